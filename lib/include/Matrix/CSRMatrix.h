@@ -3,23 +3,72 @@
 #include <Mesh.h>
 #include <Matrix.h>
 #include <TArray.h>
+#include <cstdint>
+#include <memory>
+
+struct CSRPattern
+/* CSR的非零结构，可以被多个数值不同的矩阵共享 (例如同一网格上的M, S, A)
+ * 被共享之后不应再修改
+ */
+{
+    TArray<uint32_t> row_offset;
+    TArray<uint32_t> elm_idx;
+    TArray<uint32_t> tri_pos; // 组装计划: 每个三角形局部矩阵9个元素在elements中的位置，见fem.h中的buildAssemblyPlan；只对建立时的网格有效
+
+    CSRPattern(int r) : row_offset(r + 1, 0) {}
+    CSRPattern(const Mesh &m); // 根据Mesh中每个顶点之间的连通性并行建立，同时计算组装计划
+};
 
 class CSRMatrix : public Matrix
-// 按行存储的稀疏矩阵, 存储每行不为零的元素
+/* 按行存储的稀疏矩阵, 存储每行不为零的元素
+ * 与Mesh中的顶点下标相同，行偏移与列下标使用32位整数，减少MVP时的访存量
+ * 因此非零元素个数不能超过 2^32 - 1
+ */
 {
 public:
+    std::shared_ptr<CSRPattern> pattern;
+    TArray<uint32_t> &row_offset; // 指向pattern中的数组
+    TArray<uint32_t> &elm_idx;
     Vec elements;
-    TArray<size_t> row_offset;
-    TArray<size_t> elm_idx;
 
-    CSRMatrix(int r) : Matrix(r, r), row_offset(r + 1, 0) {}
-    CSRMatrix(Mesh &m); // 根据Mesh中每个顶点之间的连通性建立
+    CSRMatrix(int r);
+    CSRMatrix(Mesh &m);                                     // 建立新的非零结构，元素为零
+    CSRMatrix(int r, const std::shared_ptr<CSRPattern> &p); // 共享已有的非零结构，元素为零
+    CSRMatrix(int r, int c, const std::shared_ptr<CSRPattern> &p); // r x c 的矩形矩阵，例如多重网格的插值与限制算子
+    CSRMatrix(const CSRMatrix &other);                      // 共享other的非零结构，复制元素
+    CSRMatrix &operator=(const CSRMatrix &other);           // 非零结构不同且自身的结构被共享时抛出异常
     ~CSRMatrix() = default;
 
     void MVP(const Vec &x, Vec &y) const;
+    double MVP_dot(const Vec &x, Vec &y) const; // y = Ax, 返回 <x, y>
     void print() const;
     double operator()(size_t i, size_t j) const;
 };
 
 void blas_addMatrix(const CSRMatrix &M, double val, const CSRMatrix &S, CSRMatrix &A);
 // 计算A = S + val * M
+
+bool samePattern(const CSRPattern &a, const CSRPattern &b); // 行偏移与列下标都相同，同一个对象时直接返回
+
+/*-------------------稀疏矩阵乘法-------------------*/
+/* 结果的每行列下标递增
+ * 乘积按行并行，每个线程使用长度为列数的标记/累加数组，不需要原子操作
+ * 符号计算分两遍: 先统计每行长度，再写入列下标；之后数值计算按得到的结构累加
+ * 非零结构不变而数值改变时(例如时间步长改变)，只需要调用 *Numeric 按已有结构重新计算数值
+ */
+
+CSRMatrix transpose(const CSRMatrix &A);
+
+CSRMatrix multiply(const CSRMatrix &A, const CSRMatrix &B);
+// C = AB
+void multiplyNumeric(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C);
+// C的结构由multiply(A, B)得到，只重新计算数值
+
+CSRMatrix tripleProduct(const CSRMatrix &R, const CSRMatrix &A, const CSRMatrix &P);
+/* C = RAP，逐行融合计算: C的第I行为 sum_i R_Ii sum_k A_ik P_k*
+ * 不存储中间结果AP，也不需要其结构
+ */
+void tripleProductNumeric(const CSRMatrix &R, const CSRMatrix &A, const CSRMatrix &P, CSRMatrix &C);
+
+CSRMatrix galerkinProduct(const CSRMatrix &A, const CSRMatrix &P);
+// C = P^T A P
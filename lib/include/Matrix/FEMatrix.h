@@ -27,28 +27,27 @@ public:
      * S.diag有n个元素，S.offdiag有3n个元素
      * 可以使用一个函数将M添加到S中方便计算
      * 同时offdiag中元素的实际位置需要与Mesh进行对应，因此需要引入对应的Mesh
+     *
+     * 刚度矩阵的offdiag按结构数组(SoA)存储: [S_AB(全部三角形), S_AC(全部三角形), S_BC(全部三角形)]
+     * 三角形的顶点下标同样拆分为ia, ib, ic三个数组，MVP时可以连续地读取并向量化
+     * 任意以三角形为单位组装的对称矩阵(例如 M + c * S)都可以用P1_Stiffness类型表示
      */
     Mesh &m;
+    TArray<uint32_t> ia; // 第t个三角形的三个顶点
+    TArray<uint32_t> ib;
+    TArray<uint32_t> ic;
 
     // FEMType表示矩阵的类型是质量还是刚度
-    FEMatrix(Mesh &mesh, FEMType fem_type) : Matrix(mesh.vertex_count(), mesh.vertex_count()), diag(mesh.vertex_count(), 0.0), m(mesh), femtype(fem_type)
-    {
-        if (femtype == P1_Mass)
-        {
-            offdiag.resize(mesh.triangle_count());
-        }
-        else if (femtype == P1_Stiffness)
-        {
-            offdiag.resize(3 * mesh.triangle_count());
-        }
-        offdiag.setAll(0);
-    }
+    FEMatrix(Mesh &mesh, FEMType fem_type);
     ~FEMatrix() = default;
 
     void MVP(const Vec &x, Vec &y) const;
     void print() const;
 };
 
+void blas_addMatrix(const FEMatrix &M, double val, const FEMatrix &S, FEMatrix &A);
+// 计算A = val * M + S，M与S可以是任意类型，A需要为P1_Stiffness类型
+
 void MVP_P1_Mass(const FEMatrix &M, const Vec &x, Vec &y);
 
 void MVP_P1_Sniffness(const FEMatrix &M, const Vec &x, Vec &y);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Matrix.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+
+class LinearCombinationMatrix : public Matrix
+/* 表示 alpha * M + beta * S，不单独存储组合后的矩阵
+ * M与S需要共享同一个CSRPattern，MVP时对共享的结构只遍历一次，同时读取两组数值
+ * 改变系数只需要调用setCoefficients，不需要重新组装
+ */
+{
+public:
+    const CSRMatrix &M;
+    const CSRMatrix &S;
+    double alpha;
+    double beta;
+
+    LinearCombinationMatrix(const CSRMatrix &M, const CSRMatrix &S, double alpha = 1.0, double beta = 1.0);
+
+    void setCoefficients(double a, double b)
+    {
+        alpha = a;
+        beta = b;
+    }
+    void MVP(const Vec &x, Vec &y) const;
+    double MVP_dot(const Vec &x, Vec &y) const; // y = Ax, 返回 <x, y>
+    void assemble(CSRMatrix &A) const;         // 写出 A = alpha * M + beta * S，A的结构与M相同，用于需要显式矩阵的直接法
+};
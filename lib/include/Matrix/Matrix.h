@@ -12,6 +12,14 @@ public:
 
     // 纯虚函数，需要每个子类进行实现
     virtual void MVP(const Vec &x, Vec &y) const = 0;
-    
+
+    // 计算 y = Ax 并同时返回 <x, y>
+    // 子类可以将内积融合进MVP的同一次遍历中，减少对向量的访存
+    virtual double MVP_dot(const Vec &x, Vec &y) const
+    {
+        MVP(x, y);
+        return dot(x, y);
+    }
+
     virtual ~Matrix() = default;
 };
\ No newline at end of file
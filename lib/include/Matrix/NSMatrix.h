@@ -9,4 +9,5 @@ public:
     Mesh &mesh;
 
     NSMatrix(Mesh &m) : CSRMatrix(m), mesh(m) {}
+    NSMatrix(Mesh &m, const NSMatrix &other) : CSRMatrix(m.vertex_count(), other.pattern), mesh(m) {} // 与同一网格上的other共享非零结构
 };
\ No newline at end of file
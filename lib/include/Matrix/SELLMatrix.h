@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Matrix.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <cstdint>
+
+class SELLMatrix : public Matrix
+/* SELL-C-sigma (分片ELLPACK) 格式的稀疏矩阵
+ * 每C行组成一个分片，分片内按列主序存储，宽度为分片内最长行的长度，不足的部分补零
+ * 这样分片内C行的同一个位置在内存中连续，MVP的内层循环可以对C行同时向量化
+ * sigma > 1 时，在每sigma行的窗口内按行长度从大到小排序后再分片，减少补零
+ * 立方体球面的P1网格几乎所有行都有7个非零元，默认sigma = 1，不需要排序
+ */
+{
+public:
+    static const int C = 8; // 分片高度，AVX-512一次处理8个double
+
+    int sigma;
+    int nchunks;
+    TArray<uint32_t> chunk_offset; // 分片k的元素从values[chunk_offset[k]]开始，共 C * chunk_width[k] 个
+    TArray<uint32_t> chunk_width;
+    TArray<uint32_t> col_idx;      // 补零的位置列下标为该行自身
+    Vec values;
+    TArray<uint32_t> row_perm; // 分片中第i个位置对应的原矩阵的行，sigma = 1 时为空
+    TArray<uint32_t> csr_pos;  // 每个位置对应CSR中元素的下标，补零为UINT32_MAX，用于更新数值
+
+    SELLMatrix() : Matrix(0, 0), sigma(1), nchunks(0) {}
+    SELLMatrix(const CSRMatrix &A, int sigma = 1);
+
+    void update(const CSRMatrix &A); // A的非零结构与构造时相同，只更新数值
+    void update(const CSRMatrix &A, double alpha, const CSRMatrix &B, double beta); // 数值为 alpha * A + beta * B，A与B结构相同
+    void MVP(const Vec &x, Vec &y) const;
+    double fillRatio() const; // 存储的元素个数(包括补零)与非零元素个数之比
+};
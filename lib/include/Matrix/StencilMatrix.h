@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Matrix.h>
+#include <CSRMatrix.h>
+#include <Mesh.h>
+#include <TArray.h>
+#include <cstdint>
+
+class StencilMatrix : public Matrix
+/* 立方体/球面网格上按结构网格模板存储的矩阵
+ * load_cube生成的网格由6个 n x n (n = subdiv + 1) 的结构网格面拼接而成，每个单元沿同一条对角线分为两个三角形
+ * 因此面内部的点恰好有7个非零元：自身、上下左右4个点以及对角线方向的2个点
+ *
+ * 面内部 2 <= i, j <= n - 3 的点称为核心点，其模板涉及的点都只属于这个面
+ * 而同一面内同一行的内部点 (1 <= j <= n - 2) 在不重复的编号中是连续的
+ * 所以核心点的MVP按行计算，只需要当前行和上下两行的起始编号，内层循环不读取任何列下标
+ * 7个系数按 [面][系数][行][列] 的SoA存储，内层循环对列连续访问，可以向量化
+ *
+ * 其余的点(面的边界，以及与边界相邻的一圈点)组成的行以CSR格式单独存储
+ */
+{
+public:
+    int n; // 每个面每行的点数
+    int m; // 每个面每行的核心点数 n - 4，subdiv < 4 时为0，全部走CSR
+    int diag[6]; // 对角线方向：1 表示 (i+1, j+1) 与 (i-1, j-1) 相连，-1 表示 (i+1, j-1) 与 (i-1, j+1) 相连
+
+    TArray<uint32_t> row_base; // 第 f * m + (i - 2) 个核心行中 (i, 2) 的编号
+    TArray<uint32_t> up_base;  // (i + 1, 2) 的编号
+    TArray<uint32_t> down_base; // (i - 1, 2) 的编号
+
+    TArray<uint32_t> seam_row;    // 不是核心点的行
+    TArray<uint32_t> seam_offset; // seam_row[k] 的元素为 [seam_offset[k], seam_offset[k + 1])
+    TArray<uint32_t> seam_idx;
+
+    /* 前 6 * 7 * m * m 个为核心点的系数，之后为CSR部分的元素
+     * 核心系数顺序为 自身, (i, j-1), (i, j+1), (i-1, j), (i+1, j), (i-1, j-diag), (i+1, j+diag)
+     */
+    Vec values;
+    TArray<uint32_t> csr_pos; // 每个系数对应原CSR中元素的下标，用于更新数值
+
+    StencilMatrix() : Matrix(0, 0), n(0), m(0), diag{} {}
+    StencilMatrix(const Mesh &mesh, const CSRMatrix &A); // mesh需要保存dupToNoDupIndex，A为mesh上组装的矩阵
+
+    void update(const CSRMatrix &A); // A的非零结构与构造时相同，只更新数值
+    void update(const CSRMatrix &A, double alpha, const CSRMatrix &B, double beta); // 数值为 alpha * A + beta * B，A与B结构相同
+    void MVP(const Vec &x, Vec &y) const;
+    size_t coreRows() const { return (size_t)6 * m * m; }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Matrix.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <cstdint>
+
+class SymCSRMatrix : public Matrix
+/* 对称稀疏矩阵，只按行存储上三角部分(包括对角线)，每行的第一个元素为对角元
+ * 质量矩阵、刚度矩阵以及 M + dt * nu * S 都是对称的，存储量与MVP的访存量约减半
+ * MVP时第i行的元素 a_ij (j > i) 同时贡献 y[i] += a_ij * x[j] 与 y[j] += a_ij * x[i]
+ * 后者会写入其他行，为避免竞争，按非零元数量将行划分为若干段，每个线程负责一段:
+ *   列在本段内的贡献直接写入y，超出本段但不远的写入该段私有的窗口 [段尾, part_col_end)
+ *   窗口长度不超过本段元素数的 1/WindowRatio，更远的元素(例如立方体球面上跨面的边)单独记录，按列所在的段分组
+ *   最后每段累加之前各段窗口中落在本段内的部分，以及列在本段内的远处元素的贡献
+ * 窗口与远处元素的总量与分段数无关地受控，不会因为少数远处的列使每段的窗口延伸到最后一行
+ */
+{
+public:
+    static const int WindowRatio = 8;
+
+    Vec elements;
+    TArray<uint32_t> row_offset;
+    TArray<uint32_t> elm_idx;
+
+    int nparts;                    // 行的分段数量
+    TArray<uint32_t> part_row;     // 第p段为 [part_row[p], part_row[p + 1])
+    TArray<uint32_t> part_col_end; // 第p段窗口的末尾，列下标不小于它的元素为远处元素
+    TArray<size_t> window_offset;  // 第p段窗口在window中的起始位置，长度为 part_col_end[p] - part_row[p + 1]
+    mutable Vec window;
+    TArray<uint32_t> far_offset;   // 列在第q段内的远处元素为 [far_offset[q], far_offset[q + 1])
+    TArray<uint32_t> far_row;      // 远处元素所在的行
+    TArray<uint32_t> far_pos;      // 远处元素在elements中的位置
+
+    SymCSRMatrix() : Matrix(0, 0), nparts(0) {}
+    SymCSRMatrix(const CSRMatrix &A, int parts = 0); // 由完整存储的对称矩阵取上三角部分，parts为分段数量，0时取最大线程数
+
+    void update(const CSRMatrix &A);                    // A的非零结构与构造时相同，只更新数值
+    void extract(const CSRMatrix &A, Vec &values) const; // 按本矩阵的结构取出A的上三角数值，A的非零结构与构造时相同
+    void MVP(const Vec &x, Vec &y) const;
+    void combinedMVP(const Vec &x, Vec &y, double alpha, const Vec &other, double beta) const; // y = (alpha * A + beta * B) x，other为extract得到的B的数值
+    double operator()(size_t i, size_t j) const;
+
+private:
+    void partition(int parts); // 按非零元数量划分行，并计算每段的窗口与远处元素
+    template <typename Value>
+    void multiply(const Vec &x, Vec &y, Value val) const; // MVP的实现，val(i)为第i个存储元素的数值
+};
+
+class SymLinearCombinationMatrix : public Matrix
+/* 表示 alpha * M + beta * S，M为SymCSRMatrix，S只存储按M的结构取出的上三角数值
+ * MVP时对M的结构只遍历一次，同时读取两组数值，不单独存储组合后的矩阵
+ */
+{
+public:
+    const SymCSRMatrix &M;
+    const Vec &S;
+    double alpha;
+    double beta;
+
+    SymLinearCombinationMatrix(const SymCSRMatrix &M, const Vec &S, double alpha = 1.0, double beta = 1.0)
+        : Matrix(M.rows, M.cols), M(M), S(S), alpha(alpha), beta(beta) {}
+
+    void setCoefficients(double a, double b)
+    {
+        alpha = a;
+        beta = b;
+    }
+    void MVP(const Vec &x, Vec &y) const { M.combinedMVP(x, y, alpha, S, beta); }
+};
+
+void blas_addMatrix(const SymCSRMatrix &M, double val, const SymCSRMatrix &S, SymCSRMatrix &A);
+// 计算A = val * M + S，三个矩阵的非零结构相同
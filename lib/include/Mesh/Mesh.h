@@ -3,6 +3,8 @@
 #include <TArray.h>
 #include <vec3.h>
 #include <cstdint>
+#include <algorithm>
+#include <omp.h>
 
 typedef int MeshType;
 
@@ -13,10 +15,33 @@ public:
     TArray<uint32_t> indices; // 每三个顶点为一组表示三角形
     MeshType meshtype;
     int subdiv;
-    int *dupToNoDupIndex;
+    int *dupToNoDupIndex = nullptr;
+
+    /* 三角形着色: 将三角形按编号顺序分为大小为color_block_size的块，对块进行着色
+     * 同一颜色的块之间没有公共顶点，可以并行地向顶点累加而不需要原子操作
+     * 块内的三角形由一个线程按原来的顺序处理，保持访存的局部性
+     * 三角形的编号与空间位置无关时(例如打乱顺序的网格)块之间普遍共享顶点，此时减小块的大小直到逐个三角形着色
+     */
+    static const int DefaultColorBlockSize = 512;
+    int color_block_size = DefaultColorBlockSize; // 单线程时也按这个大小分块
+    TArray<uint32_t> color_block;  // 按颜色排列的块编号，第b块为三角形 [b * color_block_size, (b + 1) * color_block_size)
+    TArray<uint32_t> color_offset; // 第k种颜色的块为 color_block[color_offset[k], color_offset[k + 1])
+    bool coloring_failed = false;  // 逐个三角形着色仍超过颜色上限，之后不再尝试
 
     size_t vertex_count() const { return vertices.size; }
     size_t triangle_count() const { return indices.size / 3; }
+    int color_count() const { return color_offset.size ? (int)color_offset.size - 1 : 0; }
+
+    bool buildColoring(int blockSize = DefaultColorBlockSize); // 贪心着色，在可用的颜色中选择当前块最少的；颜色不够时块大小减半重试，全部失败返回false
+    bool ensureColoring();                                     // 尚未着色时先着色，返回是否有可用的着色
+
+    /* 逐颜色并行地对每个块调用f(t0, t1)，块内三角形为 [t0, t1)，需要时先着色
+     * 单线程或无法着色时按原来的顺序串行处理，f不需要原子操作；需要并行的调用者可以先用ensureColoring判断，自行使用原子操作
+     */
+    template <typename F>
+    void forEachBlockColored(F f);
+    template <typename F>
+    void forEachTriangleColored(F f); // 逐颜色并行地对每个三角形t调用f(t)
 
     Mesh() = default;
     Mesh(int subdiv, MeshType meshtype);
@@ -36,4 +61,47 @@ public:
 int load_cube(Mesh &m, const int subdiv);
 int load_sphere(Mesh &m, const int subdiv);
 int load_cube(Mesh &m, const int subdiv, bool saveDTND);
-int load_sphere(Mesh &m, const int subdiv, bool saveDTND);
\ No newline at end of file
+int load_sphere(Mesh &m, const int subdiv, bool saveDTND);
+
+template <typename F>
+void Mesh::forEachBlockColored(F f)
+{
+    // 单线程时按原来的顺序处理，相邻的块共享顶点，缓存命中更好
+    if (omp_get_max_threads() == 1 || !ensureColoring())
+    {
+        const size_t bs = color_block_size;
+        for (size_t t0 = 0; t0 < triangle_count(); t0 += bs)
+        {
+            f(t0, std::min(triangle_count(), t0 + bs));
+        }
+        return;
+    }
+    const uint32_t *block = color_block.data;
+    const uint32_t *offset = color_offset.data;
+    const size_t bs = color_block_size;
+    const size_t ntri = triangle_count();
+    int ncolors = color_count();
+
+#pragma omp parallel
+    for (int k = 0; k < ncolors; ++k)
+    {
+        // omp for结束时的隐式同步保证下一种颜色开始前本颜色已经完成
+#pragma omp for schedule(dynamic, 4)
+        for (uint32_t i = offset[k]; i < offset[k + 1]; ++i)
+        {
+            f(block[i] * bs, std::min(ntri, (block[i] + 1) * bs));
+        }
+    }
+}
+
+template <typename F>
+void Mesh::forEachTriangleColored(F f)
+{
+    forEachBlockColored([&](size_t t0, size_t t1)
+    {
+        for (size_t t = t0; t < t1; ++t)
+        {
+            f(t);
+        }
+    });
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <preconditioner.h>
+#include <cholesky.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class AMGPreconditioner : public Preconditioner
+/* 光滑聚合代数多重网格 (smoothed aggregation AMG)，只使用CSR矩阵，不依赖网格的结构与顶点编号
+ * setup 逐层进行，每一步都按行并行:
+ * 1. 强连接: |a_ij| >= theta * sqrt(|a_ii a_jj|)
+ * 2. 聚合: 在强连接图上求距离为2的极大独立集(MIS-2)作为聚合的中心，以哈希值为优先级并行地逐轮确定
+ *    其余的点先加入相邻中心的聚合，再加入相邻已聚合点的聚合，MIS-2的极大性保证两步之后所有点都已聚合
+ * 3. 光滑插值: P = (I - omega D^{-1} A) P0，P0为聚合的指示矩阵，omega = 4/3 / rho(D^{-1} A)
+ * 4. Galerkin粗网格算子 A_c = P^T A P
+ * 行数不超过coarseSize时停止，最粗层用Cholesky分解直接求解
+ *
+ * apply 从零初值进行一次V循环，前后各smooth次阻尼Jacobi平滑，P对称正定
+ * update 用于A的值改变而结构不变的情况(例如NS中dt改变)，保留聚合与插值，只重新计算粗网格算子的数值与分解
+ */
+{
+public:
+    struct Level
+    {
+        const CSRMatrix *A;               // 第0层指向构造时的矩阵
+        std::unique_ptr<CSRMatrix> owned; // 粗层的A
+        std::unique_ptr<CSRMatrix> P;     // 从第l+1层到第l层的插值，最粗层为空
+        std::unique_ptr<CSRMatrix> R;     // R = P^T
+        TArray<uint32_t> aggregate;       // 每行所属的聚合，即在第l+1层中的行
+        Vec invDiag;
+        mutable Vec x, b, r, t; // 本层的解、右端项、残差与临时空间
+    };
+
+    double theta;   // 强连接阈值
+    int coarseSize; // 行数不超过coarseSize的层为最粗层
+    int maxLevels;  // 层数上限(含第0层)，在setup时生效
+    double w;       // Jacobi平滑的阻尼系数
+    int smooth;     // 前后平滑次数，至少为1
+
+    std::vector<Level> levels;
+    std::shared_ptr<const CSRPattern> pattern; // setup时A的非零结构，update时检查结构相同
+    mutable Cholesky coarse; // 最粗层的分解
+
+    AMGPreconditioner(const CSRMatrix &A, double theta = 0.08, int coarseSize = 400, int maxLevels = 20);
+
+    void setup(const CSRMatrix &A);  // 建立完整的层次
+    void update(const CSRMatrix &A); // A的结构与setup时相同，只更新数值
+    void apply(const Vec &r, Vec &z) const;
+    int levelCount() const { return (int)levels.size(); }
+    double operatorComplexity() const; // 各层非零元总数与第0层之比
+
+private:
+    void cycle(int l, const Vec &b, Vec &x) const;
+    void refreshLevel(int l); // 由第l层的A计算对角线，最粗层进行分解
+};
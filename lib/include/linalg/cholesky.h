@@ -3,19 +3,87 @@
 #include <CSRMatrix.h>
 #include <SKRMatrix.h>
 #include <TArray.h>
+#include <factorCache.h>
+#include <cstdint>
+#include <memory>
+#include <string>
 
 class Cholesky
 {
 public:
+    enum Ordering
+    {
+        Natural,         // 使用原本的顶点编号
+        RCM,             // 逆Cuthill-McKee重排，减小包络
+        NestedDissection // 嵌套剖分，减少超节点分解的填充
+    };
+
     SKRMatrix L;
     SKRMatrix A;
     TArray<int> minElmIdx;
+    TArray<size_t> value_pos; // A_CSR中每个元素在skyline中的位置，上三角部分为-1
+    std::shared_ptr<const CSRPattern> pattern; // analyze时A_CSR的非零结构，factorize时检查结构相同
     bool isInitialized;
 
+    Ordering ordering;
+    TArray<int> perm;      // 重排后第i行对应原矩阵的第perm[i]行，Natural时为空
+    size_t envelopeBefore; // 重排前后下三角包络的元素数量
+    size_t envelopeAfter;
+    Vec pb; // 重排后的右端项与解
+    Vec px;
+
+    TArray<int> parent; // 由包络结构得到的消去树: parent[j] = min{i > j : minElmIdx[i] <= j}，根为-1
+    bool taskFactor;    // 是否按消去树以任务方式进行分解，否则逐列并行
+
+    bool parallelSolve; // 是否使用分块并行的前代与回代
+    Vec y;              // 求解时的工作空间，在attach时分配，避免每次求解重新申请
+    Vec diag_elements;  // L的对角线，在compute时缓存
+
+    std::string cacheDir; // 分解结果的缓存目录，为空时不使用缓存
+    uint64_t matrixHash;  // attach时根据矩阵、epsilon与重排方式计算的哈希值，不使用缓存时为0
+    CachedFactor cached;  // 从缓存中映射的L，此时L.elements为空
+    bool fromCache;
+
+    /* 混合精度: 分解完成后L以float存储，内存与求解时的访存减半
+     * 求解后对原本的double矩阵 (A_CSR + epsilon * I) 进行迭代改进，恢复double精度
+     */
+    bool singlePrecision;
+    TArray<float> Lf;             // float存储的L，与L.column_offset对应
+    std::shared_ptr<const CSRMatrix> refMatrix; // 迭代改进使用的原矩阵的副本，只在混合精度时保存
+    double refEpsilon;
+    int maxRefine;                // 最大改进次数
+    double refineTol;             // 相对残差 |b - Ax| / |b| 小于refineTol时停止
+    int refineIter;               // 最近一次求解的改进次数
+    Vec refine_r;                 // 残差与修正量
+    Vec refine_d;
+
     Cholesky();
 
-    void attach(CSRMatrix &A_CSR);
+    void setOrdering(Ordering o) { ordering = o; } // 需要在attach之前设置
+    void setParallelSolve(bool p) { parallelSolve = p; }
+    void setTaskFactor(bool t) { taskFactor = t; }
+    void setCacheDir(const std::string &dir) { cacheDir = dir; } // 需要在attach或factorize之前设置；compute时先查找缓存，没有时分解并写入缓存
+    void setSinglePrecision(bool single, int maxIter = 10, double tol = 1e-12); // 需要在attach或factorize之前设置
+
+    const double *factorData() const { return fromCache ? cached.elements : L.elements.data; } // L的元素，与L.column_offset对应
+
+    void analyze(CSRMatrix &A_CSR);                         // 符号分解: 重排并建立skyline结构，只依赖非零结构；不分配L与A的数值，复制得到的对象只包含符号信息
+    void factorize(CSRMatrix &A_CSR, double epsilon = 0.0); // 数值分解: 结构与analyze时相同的矩阵，可以重复调用
+    void attach(CSRMatrix &A_CSR);                          // analyze并写入A的数值，之后调用compute
     void attach(CSRMatrix &A_CSR, double epsilon);
     void compute();
     void solve(Vec &b, Vec &x);
+
+private:
+    void buildSkyline();                   // 由minElmIdx建立skyline结构与消去树，不分配数值
+    void setValues(CSRMatrix &A_CSR, double epsilon);
+    void solvePermuted(Vec &b, Vec &x);    // 求解 L L^T x = b, b与x均为重排后的顺序
+    void computeColumns();                 // 逐列计算，每一列内部并行
+    void computeTasks();                   // 按消去树上的链进行任务调度
+    void factorChain(int r0, int r1);      // 分块计算链上的第 [r0, r1) 行
+    void solveFactor(Vec &b, Vec &x); // 只使用L求解，包含重排
+    template <typename T>
+    void solveSerial(const T *l, Vec &b, Vec &x);
+    template <typename T>
+    void solveParallel(const T *l, Vec &b, Vec &x);
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <CSRMatrix.h>
+#include <SKRMatrix.h>
+#include <TArray.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/* Cholesky分解结果的磁盘缓存
+ * 文件格式: 文件头 | column_offset (n + 1 个 uint64) | elements (nnz 个 double)
+ * 文件头中记录矩阵的哈希值，读取时只有哈希值、维数与元素个数全部一致才会使用
+ * 读取时使用mmap只读映射，不需要复制到内存中
+ */
+
+uint64_t hashMatrix(const CSRMatrix &A, uint64_t seed = 14695981039346656037ull);
+// 对矩阵的维数、非零结构与数值进行FNV-1a哈希
+
+uint64_t hashCombine(uint64_t h, double value);
+// 将一个数值(如epsilon)并入哈希值
+
+class MappedFile
+// 只读映射的文件，析构时解除映射
+{
+public:
+    MappedFile(const std::string &path); // 映射失败时 data() 为空
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return ptr; }
+    size_t size() const { return length; }
+
+private:
+    const char *ptr;
+    size_t length;
+};
+
+class CachedFactor
+// 从缓存文件中映射得到的L
+{
+public:
+    std::shared_ptr<MappedFile> file;
+    size_t n;
+    size_t nnz;
+    const uint64_t *column_offset;
+    const double *elements;
+};
+
+std::string factorCachePath(const std::string &dir, uint64_t hash);
+// 缓存文件的路径 dir/cholesky_<hash>.bin
+
+bool loadFactor(const std::string &path, uint64_t hash, const SKRMatrix &L, CachedFactor &factor);
+/* 映射缓存文件，检查文件头与L的skyline结构
+ * 文件不存在或与L不一致时返回false
+ */
+
+bool saveFactor(const std::string &path, uint64_t hash, const SKRMatrix &L);
+/* 将L写入缓存文件，先写入临时文件再重命名，避免其他进程读到不完整的文件
+ * 目录不存在时会尝试创建，写入失败时返回false
+ */
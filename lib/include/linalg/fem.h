@@ -27,12 +27,22 @@ void addMassToStiffness(FEMatrix &S, FEMatrix &M);
 // 将质量矩阵加到刚度矩阵，方便定义和使用统一的MVP
 
 /*-------------------使用CSR矩阵建立质量和刚度矩阵-------------------*/
+void buildAssemblyPlan(const CSRPattern &P, const Mesh &mesh, TArray<uint32_t> &plan);
+/* 对每个三角形(a, b, c)，预先计算局部矩阵中(i, j)元素在CSR中的位置，存储在 plan[9 * t + 3 * i + j]
+ * 只依赖网格与非零结构，由网格建立CSRPattern时计算一次存入P.tri_pos，共享同一结构的M, S, A直接使用
+ * 组装时直接按位置累加，不再查找列下标
+ * 下面的组装函数在P.tri_pos为空时临时调用，结果不写回P，因此共享的结构在组装时只被读取
+ */
+
 void buildMassMatrix(NSMatrix &M);
 void buildMassMatrix(CSRMatrix &M, Mesh &mesh);
 
 void buildStiffnessMatrix(NSMatrix &S);
 void buildStiffnessMatrix(CSRMatrix &S, Mesh &mesh);
 
+void buildWeightedMatrix(CSRMatrix &A, Mesh &mesh, double alpha, double beta);
+// 直接组装 A = alpha * M + beta * S
+
 void addMassToStiffness(CSRMatrix &S, CSRMatrix &M);
 // 将质量矩阵加到刚度矩阵，方便定义和使用统一的MVP
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <preconditioner.h>
+#include <cstdint>
+
+class IncompleteCholesky : public Preconditioner
+/* 不完全Cholesky分解 A ≈ L L^T, 作为CG的预条件子使用
+ * level = 0 时即 IC(0), L 的结构与A的下三角部分相同
+ * level = k 时允许 k 层填充, 填充元素 (i, j) 的层数为 min(lev_ik + lev_jk + 1)
+ *
+ * analyze 进行符号分解，只依赖A的结构
+ * compute 进行数值分解，A的值改变而结构不变时只需重新调用 compute
+ * 数值分解按行进行，第i行依赖于 L_ik != 0 的第k行，因此按照依赖关系分层，同一层的行并行计算
+ * 前向求解与数值分解使用相同的分层，后向求解使用 L^T 的分层
+ */
+{
+public:
+    int n;
+    int level;    // 填充层数
+    double shift; // 对角线偏移，分解失败(主元非正)时自动增大
+
+    // L 按行存储，每一行的列下标递增，对角线为每行最后一个元素
+    TArray<size_t> L_row_offset;
+    TArray<uint32_t> L_col;
+    Vec L_val;
+    TArray<size_t> A_pos; // L中每个元素对应A.elements中的下标，填充元素为 (size_t)(-1)
+
+    // U = L^T 按行存储，对角线为每行第一个元素
+    TArray<size_t> U_row_offset;
+    TArray<uint32_t> U_col;
+    TArray<size_t> U_pos; // U中每个元素在L_val中的下标
+    Vec U_val;
+
+    // 分层调度，level_rows[level_offset[l] .. level_offset[l + 1]) 为第l层的行
+    TArray<int> fwd_level_offset;
+    TArray<int> fwd_level_rows;
+    TArray<int> bwd_level_offset;
+    TArray<int> bwd_level_rows;
+
+    mutable Vec y; // 前向求解的中间结果
+
+    IncompleteCholesky(const CSRMatrix &A, int level = 0, double shift = 0.0);
+
+    void analyze(const CSRMatrix &A);
+    void compute(const CSRMatrix &A);
+    void apply(const Vec &r, Vec &z) const;
+    size_t nnz() const { return L_val.size; }
+
+private:
+    bool factorize(const CSRMatrix &A, double s); // 使用偏移s进行一次数值分解，主元非正时返回false
+};
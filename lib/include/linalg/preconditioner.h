@@ -0,0 +1,63 @@
+#pragma once
+
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <diagMatrix.h>
+
+class Preconditioner
+// 预条件子 P ≈ A^{-1}，与Matrix::MVP类似，apply计算 z = P r
+{
+public:
+    virtual void apply(const Vec &r, Vec &z) const = 0;
+
+    virtual ~Preconditioner() = default;
+};
+
+class JacobiPreconditioner : public Preconditioner
+// P = D^{-1}, D为A的对角线
+{
+public:
+    diagMatrix D;
+
+    JacobiPreconditioner(const CSRMatrix &A);
+
+    void update(const CSRMatrix &A); // A的值改变后重新提取对角线
+    void apply(const Vec &r, Vec &z) const;
+};
+
+class SSORPreconditioner : public Preconditioner
+/* 对称超松弛预条件子
+ * P^{-1} = 1 / (w(2 - w)) * (D + wL) D^{-1} (D + wU)
+ * 直接读取A中的值，因此A的值改变后无需更新
+ */
+{
+public:
+    const CSRMatrix &A;
+    double omega;
+    TArray<size_t> diag_idx; // 每一行对角线元素在elements中的下标
+    mutable Vec y;           // 前向扫描的中间结果
+
+    SSORPreconditioner(const CSRMatrix &A, double omega = 1.0);
+
+    void apply(const Vec &r, Vec &z) const;
+};
+
+class PolynomialPreconditioner : public Preconditioner
+/* 以Jacobi缩放的Neumann级数作为多项式预条件子
+ * P = sum_{k=0}^{m} (I - theta * D^{-1} A)^k * theta * D^{-1}
+ * theta 取 D^{-1}A 谱半径的Gershgorin上界的倒数，保证P对称正定
+ * 等价于从 z = 0 出发进行 m + 1 次阻尼Jacobi迭代
+ */
+{
+public:
+    const CSRMatrix &A;
+    int degree;
+    double theta;
+    diagMatrix D;
+    mutable Vec Az; // 存放Az的临时空间
+
+    PolynomialPreconditioner(const CSRMatrix &A, int degree = 3);
+
+    void update(); // A的值改变后重新计算D和theta
+    void apply(const Vec &r, Vec &z) const;
+};
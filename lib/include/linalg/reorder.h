@@ -0,0 +1,31 @@
+#pragma once
+
+#include <TArray.h>
+#include <CSRMatrix.h>
+
+/* 稀疏矩阵的重排序
+ * perm[i] 表示重排后的第i行(列)对应原矩阵的第perm[i]行(列)
+ * 重排后的矩阵为 PA = P A P^T, 即 PA(i, j) = A(perm[i], perm[j])
+ */
+
+void reverseCuthillMcKee(const CSRMatrix &A, TArray<int> &perm);
+/* 对A的邻接图进行逆Cuthill-McKee排序，减小矩阵的带宽与包络
+ * 对每一个连通分量，从伪外围点出发进行广度优先搜索，同一层中按度数从小到大访问
+ * 最后将得到的顺序反转
+ */
+
+void nestedDissection(const CSRMatrix &A, TArray<int> &perm, int leafSize = 64);
+/* 嵌套剖分排序，用于超节点Cholesky分解以减少填充
+ * 对每个子图，从伪外围点出发进行广度优先搜索，取使两侧点数最接近的一层作为分隔集
+ * 分隔集两侧的子图递归处理，分隔集排在最后
+ * 子图点数不超过leafSize时保持原本的相对顺序
+ */
+
+void invertPermutation(const TArray<int> &perm, TArray<int> &iperm);
+// iperm[perm[i]] = i
+
+void permuteMatrix(const CSRMatrix &A, const TArray<int> &perm, CSRMatrix &PA);
+// 计算 PA = P A P^T, PA中每一行的列下标保持递增
+
+size_t envelopeSize(const CSRMatrix &A);
+// 下三角包络的元素数量(包含对角线)，即由A构建的SKRMatrix的elements大小
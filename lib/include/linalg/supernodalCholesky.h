@@ -0,0 +1,62 @@
+#pragma once
+
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <cholesky.h>
+
+class SupernodalCholesky
+/* 超节点稀疏Cholesky分解 PAP^T = L L^T，接口与Cholesky相同
+ *
+ * 符号分解(attach):
+ * 1. 默认使用嵌套剖分重排，减少填充
+ * 2. 根据A的下三角结构建立消去树 parent
+ * 3. 沿消去树遍历每一行的行子树，得到L每一列的非零元个数
+ * 4. 将消去树上相邻且结构嵌套的列 (parent[j] == j + 1, count[j] == count[j + 1] + 1) 合并为超节点
+ *    超节点中所有列的非零结构相同，因此可以用一个稠密的列主序面板存储
+ * 5. 记录每个超节点会更新哪些祖先超节点
+ *
+ * 数值分解(compute): left-looking
+ * 超节点s先收集所有后代超节点d对它的更新 L_d L_d^T，再对面板进行稠密Cholesky分解
+ * 超节点只写入自己的面板，因此按照超节点消去树的高度分层，同一层的超节点并行计算
+ */
+{
+public:
+    int n;
+    Cholesky::Ordering ordering;
+    double epsilon;
+
+    TArray<int> perm; // 重排后第i行对应原矩阵的第perm[i]行
+    CSRMatrix PA;     // 重排后的矩阵
+
+    TArray<int> parent; // 消去树
+
+    int nsuper;
+    TArray<int> super_start;     // 超节点s包含的列为 [super_start[s], super_start[s + 1])
+    TArray<int> col_to_super;    // 每一列所在的超节点
+    TArray<size_t> rows_offset;  // 超节点s的行下标为 rows[rows_offset[s] .. rows_offset[s + 1])，前ncols个为对角块
+    TArray<int> rows;
+    TArray<size_t> value_offset; // 超节点s的面板从values[value_offset[s]]开始，列主序，nrows x ncols
+    Vec values;
+
+    TArray<size_t> update_offset; // 对超节点s产生更新的后代超节点，以及对应的第一行在其rows中的位置
+    TArray<int> update_super;
+    TArray<size_t> update_pos;
+
+    TArray<int> level_offset; // 按照高度分层，同一层的超节点互相独立
+    TArray<int> level_supers;
+
+    Vec pb; // 重排后的右端项，求解时原地得到重排后的解
+
+    SupernodalCholesky();
+
+    void setOrdering(Cholesky::Ordering o) { ordering = o; } // 需要在attach之前设置
+    void attach(CSRMatrix &A_CSR);
+    void attach(CSRMatrix &A_CSR, double epsilon);
+    void compute();
+    void solve(Vec &b, Vec &x);
+
+    size_t factorSize() const { return values.size; } // L中存储的元素个数
+
+private:
+    void factorSupernode(int s, int *map, Vec &work); // 计算超节点s，map与work为线程私有的临时空间
+};
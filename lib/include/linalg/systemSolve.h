@@ -3,6 +3,7 @@
 #include <TArray.h>
 #include <Matrix.h>
 #include <COOMatrix.h>
+#include <preconditioner.h>
 #include <iostream>
 
 bool decentGradientSolve(Matrix &A, Vec &B, Vec &u, Vec &r, Vec &Ar, double *rel_error, int *iter, double tol, int iterMax = 1000);
@@ -32,6 +33,40 @@ bool conjugateGradientSolve(Matrix &A, Vec &B, Vec &u, Vec &r, Vec &p, Vec &Ap,
  * int iterMax: 最大迭代次数
  */
 
+bool pipelinedConjugateGradientSolve(Matrix &A, Vec &B, Vec &u, Vec &r, Vec &p, Vec &s, Vec &w, double *rel_error, int *iter, double tol, int iterMax = 1000);
+/* Chronopoulos-Gear 形式的共轭梯度法，输出与 conjugateGradientSolve 相同
+ * 每次迭代只遍历两次向量: 一次融合更新 p, s, u, r 并计算 <r, r>，一次融合 w = Ar 与 <r, w>
+ * Input:
+ * Matrix &A : 线性方程组的矩阵
+ * Vec &B: 右端项
+ * Vec &u: 解，大小需要合适
+ * Vec &r: 存放residue的向量
+ * Vec &p: 存放p的向量
+ * Vec &s: 存放s = Ap的向量
+ * Vec &w: 存放w = Ar的向量
+ * double *rel_error: 返回最终结果的误差
+ * int *iter: 返回迭代的次数
+ * double tol: 容许误差
+ * int iterMax: 最大迭代次数
+ */
+
+bool preconditionedConjugateGradientSolve(Matrix &A, const Preconditioner &P, Vec &B, Vec &u, Vec &r, Vec &z, Vec &p, Vec &Ap, double *rel_error, int *iter, double tol, int iterMax = 1000);
+/* 预条件共轭梯度法，rel_error 仍为 |r| / |B|，与 conjugateGradientSolve 可以直接比较
+ * Input:
+ * Matrix &A : 线性方程组的矩阵
+ * const Preconditioner &P: 预条件子，需要对称正定
+ * Vec &B: 右端项
+ * Vec &u: 解，大小需要合适
+ * Vec &r: 存放residue的向量
+ * Vec &z: 存放z = Pr的向量
+ * Vec &p: 存放p的向量
+ * Vec &Ap: 存放Ap的向量
+ * double *rel_error: 返回最终结果的误差
+ * int *iter: 返回迭代的次数
+ * double tol: 容许误差
+ * int iterMax: 最大迭代次数
+ */
+
 bool decentGradientSolve(COOMatrix &M, COOMatrix &S, Vec &B, Vec &u, double tol, int iterMax = 1000);
 
 bool conjugateGradientSolve(COOMatrix &M, COOMatrix &S, Vec &B, Vec &u, double tol, int iterMax = 1000);
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <NSMatrix.h>
 #include <Mesh.h>
 #include <vec3.h>
+#include <string>
 
 class FEMData
 // 存储求解-\Delta u + u = f的相关结果
@@ -14,6 +15,6 @@ public:
     Vec u;
     Vec B;
 
-    FEMData(int subdiv, MeshType meshtype, double (*func)(Vec3 pos));
+    FEMData(int subdiv, MeshType meshtype, double (*func)(Vec3 pos), const std::string &cacheDir = ""); // cacheDir非空时缓存Cholesky分解
 };
 
@@ -4,51 +4,102 @@
 #include <Mesh.h>
 #include <TArray.h>
 #include <diagMatrix.h>
+#include <SELLMatrix.h>
+#include <preconditioner.h>
+#include <memory>
+#include <vector>
 
-/* 多重网格法对有限元线性系统进行求解 Ax = b
- * 根据输入的初始网格信息生成三重粗网格
- * 使用输入的矩阵生成方法，在每个粗网格上生成矩阵
- * 对于粗网格，每一层的subdiv是前一层的一半
- * 要求初始网格subdiv为8的倍数
- * 此时对于b，粗网格的点都是原本细分网格的顶点，因此直接使用对应位置的值
+/* 几何多重网格法对有限元线性系统进行求解 Ax = b
+ * 从输入的网格出发，每一层的subdiv是前一层的一半，递归地生成粗网格
+ * 直到subdiv为奇数或再减半会小于coarseSubdiv为止，因此对初始subdiv没有整除的要求
+ * 使用输入的矩阵生成方法，在每个粗网格上生成矩阵；或者使用Galerkin方法，由细一层的矩阵得到 R A P
+ * 粗网格的点都是细网格的顶点，相邻两层之间的插值P预先存储为稀疏矩阵，限制为 R = P^T，均用并行的MVP计算
+ * 细网格的三角形是粗网格三角形的加细，P取粗网格P1有限元空间到细网格的自然嵌入
+ * 每一层使用阻尼Jacobi平滑，最粗层用CG求解
  * 坑：类成员使用初始化列表初始化时是根据成员在类中定义的顺序来的，而不是根据初始化列表的顺序
  * 因此假如初始化列表中后一项依赖之前项的初始化，应该在类成员声明时就考虑好顺序
  */
 class MultiGrid
 {
 public:
+    enum CycleType
+    {
+        V, // 每层递归一次
+        W, // 每层递归两次
+        F  // 先递归一次F循环，再递归一次V循环
+    };
+
+    struct Level
+    {
+        Mesh *mesh;                 // 第0层为输入的网格，其余为owned
+        std::unique_ptr<Mesh> owned;
+        std::unique_ptr<CSRMatrix> A;   // 第0层使用外部算子时为空
+        std::unique_ptr<CSRMatrix> M, S; // 按 alpha * M + beta * S 构造时保存，与A共享非零结构
+        std::unique_ptr<CSRMatrix> P;   // 从第l+1层到第l层的插值，最粗层为空
+        std::unique_ptr<CSRMatrix> R;   // 限制 R = P^T
+        std::unique_ptr<diagMatrix> D;
+        SELLMatrix sell;
+        Vec x, b, r, p, Ap; // 本层的解(粗层为误差)、右端项、残差与临时空间，第0层的x与b由solve传入
+        int preSmooth;
+        int postSmooth;
+    };
+
     MeshType mt;
     int subdiv;
     double w;
     double tol;
+    CycleType cycleType;
+    bool zeroMean; // 粗网格修正去掉均值，用于只差一个常数的奇异问题
+    bool galerkin; // 粗层的算子为 R A P，由细一层的A代数地得到，不在粗网格上重新组装
 
-    Mesh &m0; // 原本的网格
-    Mesh m1;  // 双重细分网格
-    Mesh m2;
-    Mesh m3;
-
-    NSMatrix A0; // 分别对应每个网格上的矩阵
-    NSMatrix A1;
-    NSMatrix A2;
-    NSMatrix A3;
+    std::vector<Level> levels; // levels[0]为最细层
 
-    diagMatrix D0;
+    bool useSELL; // 平滑、残差与粗网格求解中的MVP使用SELL格式
+    double alpha, beta; // 每层 A = alpha * M + beta * S 的系数
 
-    Vec r0;
-    Vec r1;
-    Vec r2;
-    Vec r3;
+    Matrix *fineOp;           // 第0层的外部算子，为空时使用levels[0].A
+    Vec fineDiagM, fineDiagS; // 外部算子时第0层M与S的对角线，平滑使用 alpha * diagM + beta * diagS
 
-    MultiGrid(Mesh &mesh, void funcBuildMatrix(NSMatrix &M));
+    /* mesh需要保存dupToNoDupIndex
+     * galerkin为true时只在最细层调用funcBuildMatrix或组装M, S，粗网格只用于建立插值
+     */
+    MultiGrid(Mesh &mesh, void funcBuildMatrix(NSMatrix &M), int coarseSubdiv = 4, bool galerkin = false);
+    MultiGrid(Mesh &mesh, double alpha, double beta, int coarseSubdiv = 4, bool galerkin = false); // 每层 A = alpha * M + beta * S，系数可以通过setCoefficients改变
+    /* 第0层使用调用者的算子 fineOp = alpha * M + beta * S (例如不单独存储的线性组合或对称存储)，只保存对角线
+     * 粗层与上面相同；galerkin时临时组装细层的M与S得到第1层的 R M P 与 R S P，之后逐层为 R A P
+     * fineOp的系数由调用者设置，需要与setCoefficients一致
+     */
+    MultiGrid(Mesh &mesh, Matrix &fineOp, const Vec &diagM, const Vec &diagS, double alpha, double beta, int coarseSubdiv = 4, bool galerkin = false);
+    void setFineOperator(Matrix &op);                // 替换第0层的外部算子，数值需要与原来相同
+    void setCoefficients(double alpha, double beta); // 重新组合A，系数不变时直接返回
+    void updateOperators();                          // A的值改变后调用：Galerkin时逐层重新计算 R A P 的数值，再更新对角线与SELL
     void solve(Vec &b, Vec &u);
+    void cycle(int l, const Vec &b, Vec &x, CycleType type); // 从第l层开始进行一次循环(平滑、粗网格修正、平滑)，x为初值
     void setOmega(double val) { w = val; }
+    void setCycle(CycleType type) { cycleType = type; }
+    void setSmoothing(int pre, int post);            // 所有层的平滑次数
+    void setSmoothing(int l, int pre, int post);     // 第l层的平滑次数
+    void setSELL(bool sell, int sigma = 1);
+    int levelCount() const { return (int)levels.size(); }
+    Matrix &op(int l); // 第l层MVP使用的矩阵
 
-    // 需要来自各个网格的顶点对应信息来将b映射到各个粗网格上
-    // 因此使用在网格构建过程中得到的dupToNoDupIndex
-
-    void projToCoarse(Vec &b, Mesh &m0, Vec &b1, Mesh &m1);                                                        // 将b从细网格m0映射到粗网格m1上，结果在b1中
-    void projToFine(Vec &b, Mesh &m0, Vec &b1, Mesh &m1);                                                          // 将b从粗网格m0映射到细网格m1上
-    void dumpedJacobi(const NSMatrix &A, const diagMatrix &D, const Vec &b, Vec &x, Vec &r, int iter);            // 重稀疏Jacobi平滑器
-    void conjugateGraidentSmooth(NSMatrix &A, Vec &b, Vec &x, int iter); // 共轭梯度平滑
+    // 插值需要各个网格的顶点对应信息，因此使用在网格构建过程中得到的dupToNoDupIndex
+    static CSRMatrix buildProlongation(Mesh &fine, Mesh &coarse);                                                 // 从粗网格到细网格的插值矩阵
+    void dumpedJacobi(const Matrix &A, const diagMatrix &D, const Vec &b, Vec &x, Vec &r, Vec &p, int iter);      // 重稀疏Jacobi平滑器，p为临时空间
+    void conjugateGraidentSmooth(Matrix &A, Vec &b, Vec &x, int iter); // 共轭梯度平滑
     void setZeroMean(Vec &x);
-};
\ No newline at end of file
+};
+
+class MultiGridPreconditioner : public Preconditioner
+/* 从零初值进行一次多重网格循环作为CG的预条件子 z = P r
+ * 前后平滑次数相同、限制为插值的转置时P对称正定
+ * 最粗层的CG只求解到mg.tol，P不是严格线性的，粗层足够小时影响可以忽略
+ */
+{
+public:
+    MultiGrid &mg;
+
+    MultiGridPreconditioner(MultiGrid &mg) : mg(mg) {}
+
+    void apply(const Vec &r, Vec &z) const;
+};
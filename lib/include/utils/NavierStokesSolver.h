@@ -3,8 +3,15 @@
 #include <Mesh.h>
 #include <TArray.h>
 #include <NSMatrix.h>
-// #include <MultiGrid.h>
+#include <SELLMatrix.h>
+#include <StencilMatrix.h>
+#include <SymCSRMatrix.h>
+#include <LinearCombinationMatrix.h>
+#include <MultiGrid.h>
 #include <cholesky.h>
+#include <list>
+#include <memory>
+#include <utility>
 
 class NavierStokesSolver
 /* 求解 NS 方程: (M + dt * nu * S) * Omega^{t+dt} = dt * M * Omega^t + dt * T(Omega^t, Psi^t)
@@ -19,7 +26,8 @@ class NavierStokesSolver
 {
 public:
     Mesh mesh;
-    NSMatrix M, S, A;
+    NSMatrix M, S;               // 共享同一个非零结构
+    LinearCombinationMatrix A;  // A = M + dt * nu * S，不单独存储
     Vec Omega;
     Vec MOmega;
     Vec Psi;
@@ -33,9 +41,51 @@ public:
 
     Cholesky cholesky;
 
-    NavierStokesSolver(int subdiv, MeshType meshtype);
+    /* 直接求解 A = M + dt * nu * S
+     * A的非零结构不变，符号分解只做一次，之后只需要数值分解
+     * 自适应步长时dt会变化，按 dt * nu 缓存最近使用的若干个分解
+     */
+    bool directSolve;
+    size_t maxFactors;
+    Cholesky symbolicA;                             // 只完成了符号分解，新的分解从它复制得到
+    std::list<std::pair<double, Cholesky>> factors; // 按最近使用排序，最近使用的在前
+
+    bool useSELL;     // CG求解Omega时使用SELL格式的A
+    SELLMatrix Asell; // 与A的非零结构相同，每一步只更新数值
+
+    bool useStencil;        // CG求解Omega时，各面内部的行按结构网格模板计算，不读取列下标
+    StencilMatrix Astencil;
+
+    /* CG求解Omega时以一次多重网格循环作为预条件子
+     * 最细层直接使用A(对称存储时为Asym)，只保存对角线，不再存储一份细网格的矩阵
+     * 粗层的M与S只组装一次，dt * nu 改变时重新组合；galerkin时粗层为 R A P，dt * nu 改变时重新计算数值
+     */
+    bool useMG;
+    std::unique_ptr<MultiGrid> mg;
+    std::unique_ptr<MultiGridPreconditioner> mgPrecond;
+    Vec z; // 预条件后的残差
+
+    /* M的MVP与CG求解Omega时使用只存储上三角的对称矩阵
+     * Msym为M，Ssym为按Msym的结构取出的S的上三角数值，A = M + dt * nu * S 在MVP时组合，不单独存储
+     * 开启时释放完整存储的M与S(包括共享的非零结构与组装计划)，关闭时重新组装
+     * 直接法、SELL与模板格式需要完整存储的M与S，不能同时开启；多重网格预条件子的最细层使用Asym，可以同时开启
+     */
+    bool symmetric;
+    SymCSRMatrix Msym;
+    Vec Ssym;
+    std::unique_ptr<SymLinearCombinationMatrix> Asym;
+
+    NavierStokesSolver(int subdiv, MeshType meshtype, const std::string &cacheDir = ""); // cacheDir非空时S的分解缓存到该目录，相同网格再次运行时直接读取
     ~NavierStokesSolver() = default;
 
+    void setDirectSolve(bool direct, size_t cacheSize = 4); // 使用Cholesky分解代替CG求解Omega
+    Cholesky &factorFor(double c);                          // 返回 M + c * S 的分解，c不在缓存中时进行分解
+    void setSELL(bool sell, int sigma = 1);
+    void setSymmetric(bool sym); // 与直接法、SELL或模板格式同时开启时抛出std::logic_error
+    void setStencil(bool stencil);
+    void setMultiGrid(bool multigrid, MultiGrid::CycleType type = MultiGrid::V, int smooth = 2, int coarseSubdiv = 4, bool galerkin = false);
+    void massMVP(const Vec &x, Vec &y) const; // y = M * x
+
     void computeStream(int *iter);
     void setZeroMean(Vec &x);
     void computeTransport();
@@ -1,6 +1,7 @@
 #include <CSRMatrix.h>
 
 #include <Mesh.h>
+#include <fem.h>
 #include <iostream>
 #include <TArray.h>
 #include <vector>
@@ -10,118 +11,210 @@
 #include <cstdint>
 #include <iomanip>
 
-CSRMatrix::CSRMatrix(Mesh &m)
-    : Matrix(m.vertex_count(), m.vertex_count()), row_offset(rows + 1, 1)
+CSRPattern::CSRPattern(const Mesh &m)
+    : row_offset(m.vertex_count() + 1, 0)
+/* 两遍扫描，不为每个三角形申请内存:
+ * 1. 统计每个顶点出现在多少个三角形中，每次出现最多带来两个相邻顶点，再加上对角元，得到每行长度的上界
+ * 2. 按上界分配临时空间，并行写入每个三角形的相邻顶点，位置由原子操作分配
+ * 3. 每行排序去重得到真实长度，再压缩到最终的数组中
+ * 4. 计算组装计划tri_pos
+ */
 {
-    /* 统计每个顶点对应的非零元素数量，然后初始化elements, row_offset 和 elm_idx
-     * 根据构建网格的特征
-     * 顶点首次在三角形中出现时，此时与三个点存在相互作用，值不为零
-     * 之后每多出现一次，因为新的三角形必然与前一个出现的三角形共一条边，因此仅多一个非零元素
-     * 最后一次出现，不增加新的顶点
-     * 因此总数为 1 + 出现次数
-     * row_offset前rows个元素为对应row的开始下标，最后多存储一个元素方便计算每一行的长度
-     */
-    // 统计每个点的出现次数
-    for (size_t t = 0; t < m.triangle_count(); ++t)
-    {
-        row_offset[m.indices[3 * t + 0]] += 1;
-        row_offset[m.indices[3 * t + 1]] += 1;
-        row_offset[m.indices[3 * t + 2]] += 1;
-    }
+    const int rows = m.vertex_count();
+    const size_t ntri = m.triangle_count();
+    const uint32_t *tri = m.indices.data;
 
-    // 将数量转换为偏移量
-    for (size_t i = 0; i < rows - 1; ++i)
+    TArray<size_t> bound(rows + 1, 0);
+    TArray<size_t> cursor(rows, 0);
+    size_t *bd = bound.data;
+    size_t *cs = cursor.data;
+
+#pragma omp parallel for
+    for (size_t t = 0; t < 3 * ntri; ++t)
     {
-        row_offset[i + 1] += row_offset[i];
+#pragma omp atomic
+        bd[tri[t] + 1] += 1;
     }
-
-    // 将元素向后移动一位
-    for (size_t i = rows; i > 0; --i)
+    for (int i = 0; i < rows; ++i)
     {
-        row_offset[i] = row_offset[i - 1];
+        bd[i + 1] = bd[i] + 2 * bd[i + 1] + 1; // 每次出现最多两个相邻顶点，再加上对角元
     }
-    row_offset[0] = 0;
-
-    size_t s = row_offset[rows]; // 此时最后一个元素为总和
-    elements.resize(s);
-    elements.setAll(0.0);
 
-    elm_idx.resize(s);
-    elm_idx.setAll(-1); // 设置为-1即size_t最大值，便于之后按大小顺序插入元素
+    TArray<uint32_t> tmp(bd[rows]);
+    uint32_t *td = tmp.data;
 
-    uint32_t a, b, c;
-    for (size_t t = 0; t < m.triangle_count(); ++t)
+#pragma omp parallel for
+    for (int i = 0; i < rows; ++i)
     {
-        a = m.indices[3 * t + 0];
-        b = m.indices[3 * t + 1];
-        c = m.indices[3 * t + 2];
+        td[bd[i]] = i;
+        cs[i] = bd[i] + 1;
+    }
 
-        std::vector<uint32_t> triangle = {a, b, c};
-        /* 对于当前三角形的每一个顶点，对于当前三角形对应的三个行，
-         * 判断是否为第一次出现，并以从小到大的顺序插入
-         */
-        size_t offset;
-        int len;
-        for (uint32_t current_vtx : triangle)
+#pragma omp parallel for
+    for (size_t t = 0; t < ntri; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
         {
-            for (uint32_t current_row : triangle)
+            uint32_t v = tri[3 * t + k];
+            size_t pos;
+#pragma omp atomic capture
             {
-                // 定位当前行
-                offset = row_offset[current_row];
-                len = row_offset[current_row + 1] - offset;
+                pos = cs[v];
+                cs[v] += 2;
+            }
+            td[pos] = tri[3 * t + (k + 1) % 3];
+            td[pos + 1] = tri[3 * t + (k + 2) % 3];
+        }
+    }
 
-                // 判断是否为第一次出现，若是则插入
-                for (int i = 0; i < len; ++i)
-                {
-                    if (elm_idx[offset + i] == current_vtx)
-                    {
-                        break; // 出现过，直接跳过
-                    }
-                    else if (elm_idx[offset + i] == (size_t)(-1))
-                    {
-                        elm_idx[offset + i] = current_vtx;
-                        break;
-                    }
-                }
+    // 每行排序去重，行很短，使用插入排序
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (int i = 0; i < rows; ++i)
+    {
+        uint32_t *first = td + bd[i];
+        size_t len = bd[i + 1] - bd[i];
+        for (size_t a = 1; a < len; ++a)
+        {
+            uint32_t v = first[a];
+            size_t b = a;
+            for (; b > 0 && first[b - 1] > v; --b)
+            {
+                first[b] = first[b - 1];
             }
+            first[b] = v;
+        }
+        row_offset[i + 1] = std::unique(first, first + len) - first;
+    }
+
+    size_t nnz = 0;
+    for (int i = 0; i < rows; ++i)
+    {
+        nnz += row_offset[i + 1];
+        if (nnz > UINT32_MAX)
+        {
+            throw std::runtime_error("CSRMatrix: too many nonzeros for 32-bit indices.");
         }
+        row_offset[i + 1] = nnz;
+    }
+
+    elm_idx.resize(nnz);
+#pragma omp parallel for
+    for (int i = 0; i < rows; ++i)
+    {
+        std::copy(td + bd[i], td + bd[i] + (row_offset[i + 1] - row_offset[i]), elm_idx.data + row_offset[i]);
     }
 
-    // 插入后将每行按大小排序
-    for (size_t row = 0; row < rows; ++row)
+    // 结构被共享之后不再修改，组装计划在建立时一次算好
+    buildAssemblyPlan(*this, m, tri_pos);
+}
+
+CSRMatrix::CSRMatrix(int r)
+    : Matrix(r, r), pattern(std::make_shared<CSRPattern>(r)), row_offset(pattern->row_offset), elm_idx(pattern->elm_idx)
+{
+}
+
+CSRMatrix::CSRMatrix(Mesh &m)
+    : CSRMatrix(m.vertex_count(), std::make_shared<CSRPattern>(m))
+{
+}
+
+CSRMatrix::CSRMatrix(int r, const std::shared_ptr<CSRPattern> &p)
+    : CSRMatrix(r, r, p)
+{
+}
+
+CSRMatrix::CSRMatrix(int r, int c, const std::shared_ptr<CSRPattern> &p)
+    : Matrix(r, c), pattern(p), row_offset(pattern->row_offset), elm_idx(pattern->elm_idx), elements(pattern->elm_idx.size, 0.0)
+{
+    if (row_offset.size != (size_t)r + 1)
     {
-        size_t offset = row_offset[row];
-        int len = row_offset[row + 1] - offset;
+        throw std::invalid_argument("Size mismatch: CSRPattern does not match the number of rows.");
+    }
+}
 
-        // 排序当前行的非零元素下标
-        std::sort(elm_idx.begin() + offset, elm_idx.begin() + offset + len);
+CSRMatrix::CSRMatrix(const CSRMatrix &other)
+    : Matrix(other.rows, other.cols), pattern(other.pattern), row_offset(pattern->row_offset), elm_idx(pattern->elm_idx), elements(other.elements)
+{
+}
+
+CSRMatrix &CSRMatrix::operator=(const CSRMatrix &other)
+// 引用成员不能重新绑定，因此复制other的非零结构到自身的pattern中
+{
+    if (this == &other)
+    {
+        return *this;
     }
+    if (pattern != other.pattern)
+    {
+        if (pattern.use_count() > 1)
+        {
+            throw std::runtime_error("CSRMatrix: cannot overwrite a shared pattern.");
+        }
+        *pattern = *other.pattern;
+    }
+    rows = other.rows;
+    cols = other.cols;
+    elements = other.elements;
+    return *this;
 }
 
 void CSRMatrix::MVP(const Vec &x, Vec &y) const
+// 每一行只由一个线程计算并写入一次，不需要清零与原子操作
 {
-    if (cols != x.size || cols != y.size)
+    if (cols != x.size || rows != y.size)
     {
         throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
     }
-    y.setAll(0.0);
 
-    size_t offset;
-    size_t len;
+    const uint32_t *offset = row_offset.data;
+    const uint32_t *idx = elm_idx.data;
+    const double *val = elements.data;
+    const double *xd = x.data;
+    double *yd = y.data;
 
-#pragma omp parallel for private(offset, len)
+#pragma omp parallel for schedule(static)
     for (int r = 0; r < rows; ++r)
     {
-        offset = row_offset[r];
-        len = row_offset[r + 1] - offset;
-        double local_sum = 0.0; // 每个线程维护局部累加器
-        for (size_t i = 0; i < len; ++i)
+        double sum = 0.0;
+        for (uint32_t i = offset[r]; i < offset[r + 1]; ++i)
         {
-            local_sum += elements[offset + i] * x[elm_idx[offset + i]];
+            sum += val[i] * xd[idx[i]];
         }
-#pragma omp atomic
-        y[r] += local_sum;
+        yd[r] = sum;
+    }
+}
+
+double CSRMatrix::MVP_dot(const Vec &x, Vec &y) const
+// 在计算 y = Ax 的同时累加 <x, y>，每一行只写一次y，无需先清零
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+    if (rows != cols)
+    {
+        throw std::invalid_argument("Size mismatch: MVP_dot requires a square matrix, <x, y> is undefined otherwise.");
+    }
+
+    const uint32_t *offset = row_offset.data;
+    const uint32_t *idx = elm_idx.data;
+    const double *val = elements.data;
+    const double *xd = x.data;
+    double *yd = y.data;
+
+    double xy = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : xy)
+    for (int r = 0; r < rows; ++r)
+    {
+        double local_sum = 0.0;
+        for (uint32_t i = offset[r]; i < offset[r + 1]; ++i)
+        {
+            local_sum += val[i] * xd[idx[i]];
+        }
+        yd[r] = local_sum;
+        xy += local_sum * xd[r];
     }
+    return xy;
 }
 
 void blas_addMatrix(const CSRMatrix &M, double val, const CSRMatrix &S, CSRMatrix &A)
@@ -133,6 +226,17 @@ void blas_addMatrix(const CSRMatrix &M, double val, const CSRMatrix &S, CSRMatri
     }
 }
 
+bool samePattern(const CSRPattern &a, const CSRPattern &b)
+{
+    if (&a == &b)
+    {
+        return true;
+    }
+    return a.row_offset.size == b.row_offset.size && a.elm_idx.size == b.elm_idx.size &&
+           std::equal(a.row_offset.begin(), a.row_offset.end(), b.row_offset.begin()) &&
+           std::equal(a.elm_idx.begin(), a.elm_idx.end(), b.elm_idx.begin());
+}
+
 void CSRMatrix::print() const
 {
     // 保存 std::cout 的当前格式
@@ -203,3 +307,215 @@ double CSRMatrix::operator()(size_t i, size_t j) const
     // 如果没找到，返回 0.0
     return 0.0;
 }
+
+/*-------------------稀疏矩阵乘法-------------------*/
+CSRMatrix transpose(const CSRMatrix &A)
+/* 统计每列的元素个数并求前缀和，再按行号递增顺序写入
+ * 转置后每行的列下标自然递增，不需要排序，额外空间只有一个长度为cols的数组
+ * 按行并行写入需要每个线程按列保存各自的起始位置，空间与前缀和均为 O(线程数 * cols)，因此串行写入
+ */
+{
+    auto P = std::make_shared<CSRPattern>(A.cols);
+    CSRMatrix T(A.cols, A.rows, P);
+    uint32_t *offset = P->row_offset.data;
+    size_t nnz = A.elements.size;
+    int cols = A.cols;
+
+    P->elm_idx.resize(nnz);
+    T.elements.resize(nnz);
+    uint32_t *idx = P->elm_idx.data;
+    double *val = T.elements.data;
+
+    for (size_t i = 0; i < nnz; ++i)
+    {
+        offset[A.elm_idx[i] + 1] += 1;
+    }
+    for (int c = 0; c < cols; ++c)
+    {
+        offset[c + 1] += offset[c];
+    }
+
+    std::vector<uint32_t> next(offset, offset + cols); // 转置后每行下一个写入的位置
+    for (int r = 0; r < A.rows; ++r)
+    {
+        for (uint32_t i = A.row_offset[r]; i < A.row_offset[r + 1]; ++i)
+        {
+            uint32_t pos = next[A.elm_idx[i]]++;
+            idx[pos] = r;
+            val[pos] = A.elements[i];
+        }
+    }
+    return T;
+}
+
+template <typename RowVisit>
+static std::shared_ptr<CSRPattern> symbolicProduct(int rows, int cols, RowVisit visit)
+/* visit(r, f) 对结果第r行的每一项贡献调用 f(c, v)
+ * 第一遍用标记数组统计每行不同列的个数，第二遍按准确的大小写入列下标并排序
+ * 不使用动态增长的缓冲区，避免重新分配与多余的缺页
+ */
+{
+    auto P = std::make_shared<CSRPattern>(rows);
+    uint32_t *offset = P->row_offset.data;
+
+#pragma omp parallel
+    {
+        std::vector<int> mark(cols, -1);
+#pragma omp for schedule(dynamic, 256)
+        for (int r = 0; r < rows; ++r)
+        {
+            uint32_t count = 0;
+            visit(r, [&](uint32_t c, double)
+            {
+                if (mark[c] != r)
+                {
+                    mark[c] = r;
+                    ++count;
+                }
+            });
+            offset[r + 1] = count;
+        }
+    }
+
+    size_t nnz = 0;
+    for (int r = 0; r < rows; ++r)
+    {
+        nnz += offset[r + 1];
+        if (nnz > UINT32_MAX)
+        {
+            throw std::runtime_error("CSRMatrix: too many nonzeros for 32-bit indices.");
+        }
+        offset[r + 1] = nnz;
+    }
+
+    P->elm_idx.resize(nnz);
+    uint32_t *idx = P->elm_idx.data;
+#pragma omp parallel
+    {
+        std::vector<int> mark(cols, -1);
+#pragma omp for schedule(dynamic, 256)
+        for (int r = 0; r < rows; ++r)
+        {
+            uint32_t *first = idx + offset[r];
+            uint32_t len = 0;
+            visit(r, [&](uint32_t c, double)
+            {
+                if (mark[c] != r)
+                {
+                    mark[c] = r;
+                    first[len++] = c;
+                }
+            });
+            std::sort(first, first + len);
+        }
+    }
+    return P;
+}
+
+template <typename RowVisit>
+static void numericProduct(CSRMatrix &C, RowVisit visit)
+// 每个线程用稠密数组累加一行，再按C的结构取出并清零
+{
+    const uint32_t *offset = C.row_offset.data;
+    const uint32_t *idx = C.elm_idx.data;
+    double *val = C.elements.data;
+
+#pragma omp parallel
+    {
+        std::vector<double> acc(C.cols, 0.0);
+#pragma omp for schedule(dynamic, 256)
+        for (int r = 0; r < C.rows; ++r)
+        {
+            visit(r, [&](uint32_t c, double v)
+            { acc[c] += v; });
+            for (uint32_t i = offset[r]; i < offset[r + 1]; ++i)
+            {
+                val[i] = acc[idx[i]];
+                acc[idx[i]] = 0.0;
+            }
+        }
+    }
+}
+
+// 返回对AB第r行的贡献逐项调用f的函数
+static auto productRow(const CSRMatrix &A, const CSRMatrix &B)
+{
+    return [&A, &B](int r, auto f)
+    {
+        for (uint32_t i = A.row_offset[r]; i < A.row_offset[r + 1]; ++i)
+        {
+            uint32_t k = A.elm_idx[i];
+            double a = A.elements[i];
+            for (uint32_t j = B.row_offset[k]; j < B.row_offset[k + 1]; ++j)
+            {
+                f(B.elm_idx[j], a * B.elements[j]);
+            }
+        }
+    };
+}
+
+static auto tripleProductRow(const CSRMatrix &R, const CSRMatrix &A, const CSRMatrix &P)
+{
+    return [&R, &A, &P](int r, auto f)
+    {
+        for (uint32_t i = R.row_offset[r]; i < R.row_offset[r + 1]; ++i)
+        {
+            uint32_t fine = R.elm_idx[i];
+            double ri = R.elements[i];
+            for (uint32_t k = A.row_offset[fine]; k < A.row_offset[fine + 1]; ++k)
+            {
+                uint32_t col = A.elm_idx[k];
+                double ra = ri * A.elements[k];
+                for (uint32_t j = P.row_offset[col]; j < P.row_offset[col + 1]; ++j)
+                {
+                    f(P.elm_idx[j], ra * P.elements[j]);
+                }
+            }
+        }
+    };
+}
+
+CSRMatrix multiply(const CSRMatrix &A, const CSRMatrix &B)
+{
+    if (A.cols != B.rows)
+    {
+        throw std::invalid_argument("Size mismatch: multiply requires A.cols == B.rows.");
+    }
+    CSRMatrix C(A.rows, B.cols, symbolicProduct(A.rows, B.cols, productRow(A, B)));
+    numericProduct(C, productRow(A, B));
+    return C;
+}
+
+void multiplyNumeric(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C)
+{
+    if (A.cols != B.rows || C.rows != A.rows || C.cols != B.cols)
+    {
+        throw std::invalid_argument("Size mismatch: multiplyNumeric requires C = AB.");
+    }
+    numericProduct(C, productRow(A, B));
+}
+
+CSRMatrix tripleProduct(const CSRMatrix &R, const CSRMatrix &A, const CSRMatrix &P)
+{
+    if (R.cols != A.rows || A.cols != P.rows)
+    {
+        throw std::invalid_argument("Size mismatch: tripleProduct requires R.cols == A.rows and A.cols == P.rows.");
+    }
+    CSRMatrix C(R.rows, P.cols, symbolicProduct(R.rows, P.cols, tripleProductRow(R, A, P)));
+    numericProduct(C, tripleProductRow(R, A, P));
+    return C;
+}
+
+void tripleProductNumeric(const CSRMatrix &R, const CSRMatrix &A, const CSRMatrix &P, CSRMatrix &C)
+{
+    if (R.cols != A.rows || A.cols != P.rows || C.rows != R.rows || C.cols != P.cols)
+    {
+        throw std::invalid_argument("Size mismatch: tripleProductNumeric requires C = RAP.");
+    }
+    numericProduct(C, tripleProductRow(R, A, P));
+}
+
+CSRMatrix galerkinProduct(const CSRMatrix &A, const CSRMatrix &P)
+{
+    return tripleProduct(transpose(P), A, P);
+}
@@ -3,63 +3,142 @@
 #include <Mesh.h>
 #include <cstdint>
 #include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
 
-void MVP_P1_Mass(const FEMatrix &M, const Vec &x, Vec &y)
+FEMatrix::FEMatrix(Mesh &mesh, FEMType fem_type)
+    : Matrix(mesh.vertex_count(), mesh.vertex_count()), diag(mesh.vertex_count(), 0.0), femtype(fem_type), m(mesh),
+      ia(mesh.triangle_count()), ib(mesh.triangle_count()), ic(mesh.triangle_count())
 {
-    y.setAll(0);
+    size_t ntri = mesh.triangle_count();
+    if (femtype == P1_Mass)
+    {
+        offdiag.resize(ntri);
+    }
+    else if (femtype == P1_Stiffness)
+    {
+        offdiag.resize(3 * ntri);
+    }
+    offdiag.setAll(0);
+
+#pragma omp parallel for
+    for (size_t t = 0; t < ntri; ++t)
+    {
+        ia[t] = mesh.indices[3 * t + 0];
+        ib[t] = mesh.indices[3 * t + 1];
+        ic[t] = mesh.indices[3 * t + 2];
+    }
+}
+
+static void MVP_P1(const FEMatrix &M, const double *sab, const double *sac, const double *sbc, const Vec &x, Vec &y)
+/* y = diag * x + 每个三角形的非对角线部分
+ * 按着色的块并行，同一颜色的块没有公共顶点
+ * 块内每次处理BATCH个三角形: 先对连续存储的数据向量化地读取x并计算三个顶点的贡献，再逐个累加到y
+ * 块内的三角形共享顶点，累加这一步不能向量化
+ * 网格无法着色时按三角形并行，用原子操作累加
+ */
+{
+    if (M.cols != x.size || M.rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const uint32_t *ia = M.ia.data;
+    const uint32_t *ib = M.ib.data;
+    const uint32_t *ic = M.ic.data;
+    const double *xd = x.data;
+    double *yd = y.data;
 
     // 先计算对角线
+#pragma omp parallel for
     for (int i = 0; i < M.rows; ++i)
     {
-        y[i] = M.diag[i] * x[i];
+        yd[i] = M.diag[i] * xd[i];
     }
 
-    // 根据三角形依次计算非对角线
-    for (size_t t = 0; t < M.m.triangle_count(); ++t)
+    if (omp_get_max_threads() > 1 && !M.m.ensureColoring())
     {
-        uint32_t a = M.m.indices[3 * t];
-        uint32_t b = M.m.indices[3 * t + 1];
-        uint32_t c = M.m.indices[3 * t + 2];
-
-        // 每个三角形仅对应offdiag中的一个元素，但
-        double val = M.offdiag[t];
-
-        y[a] += val * x[b];
-        y[b] += val * x[a];
-        y[a] += val * x[c];
-        y[c] += val * x[a];
-        y[b] += val * x[c];
-        y[c] += val * x[b];
-        // 同时还有下三角的部分
+        size_t ntri = M.m.triangle_count();
+#pragma omp parallel for
+        for (size_t t = 0; t < ntri; ++t)
+        {
+            double xa = xd[ia[t]], xb = xd[ib[t]], xc = xd[ic[t]];
+#pragma omp atomic
+            yd[ia[t]] += sab[t] * xb + sac[t] * xc;
+#pragma omp atomic
+            yd[ib[t]] += sab[t] * xa + sbc[t] * xc;
+#pragma omp atomic
+            yd[ic[t]] += sac[t] * xa + sbc[t] * xb;
+        }
+        return;
     }
+
+    const int BATCH = 64;
+    M.m.forEachBlockColored([&](size_t t0, size_t t1)
+    {
+        double ya[BATCH], yb[BATCH], yc[BATCH];
+        for (size_t s = t0; s < t1; s += BATCH)
+        {
+            int len = std::min((size_t)BATCH, t1 - s);
+#pragma omp simd
+            for (int k = 0; k < len; ++k)
+            {
+                size_t t = s + k;
+                double xa = xd[ia[t]], xb = xd[ib[t]], xc = xd[ic[t]];
+                ya[k] = sab[t] * xb + sac[t] * xc;
+                yb[k] = sab[t] * xa + sbc[t] * xc;
+                yc[k] = sac[t] * xa + sbc[t] * xb;
+            }
+            for (int k = 0; k < len; ++k)
+            {
+                yd[ia[s + k]] += ya[k];
+                yd[ib[s + k]] += yb[k];
+                yd[ic[s + k]] += yc[k];
+            }
+        }
+    });
+}
+
+void MVP_P1_Mass(const FEMatrix &M, const Vec &x, Vec &y)
+{
+    // 每个三角形仅对应offdiag中的一个元素，三条边的值相同
+    const double *val = M.offdiag.data;
+    MVP_P1(M, val, val, val, x, y);
 }
 
 void MVP_P1_Sniffness(const FEMatrix &M, const Vec &x, Vec &y)
 {
-    y.setAll(0);
+    // 按照AB, AC, BC的顺序存储非对角线元素
+    size_t ntri = M.m.triangle_count();
+    const double *val = M.offdiag.data;
+    MVP_P1(M, val, val + ntri, val + 2 * ntri, x, y);
+}
+
+void blas_addMatrix(const FEMatrix &M, double val, const FEMatrix &S, FEMatrix &A)
+{
+    if (A.femtype != FEMatrix::P1_Stiffness)
+    {
+        throw std::invalid_argument("blas_addMatrix: result FEMatrix must be of type P1_Stiffness.");
+    }
+    size_t ntri = A.m.triangle_count();
 
-    // 先计算对角线
-    for (int i = 0; i < M.rows; ++i)
+#pragma omp parallel for
+    for (int i = 0; i < A.rows; ++i)
     {
-        y[i] = M.diag[i] * x[i];
+        A.diag[i] = val * M.diag[i] + S.diag[i];
     }
 
-    // 根据三角形依次计算非对角线
-    for (size_t t = 0; t < M.m.triangle_count(); ++t)
+    // 质量矩阵每个三角形只有一个值，对应三条边
+    size_t mstride = (M.femtype == FEMatrix::P1_Mass) ? 0 : ntri;
+    size_t sstride = (S.femtype == FEMatrix::P1_Mass) ? 0 : ntri;
+#pragma omp parallel for
+    for (size_t t = 0; t < ntri; ++t)
     {
-        uint32_t a = M.m.indices[3 * t];
-        uint32_t b = M.m.indices[3 * t + 1];
-        uint32_t c = M.m.indices[3 * t + 2];
-
-        // 按照AB, AC, BC的顺序存储非对角线元素
-        // 因此是a行b列，a行c列，b行c列的顺序
-        y[a] += M.offdiag[3 * t + 0] * x[b];
-        y[b] += M.offdiag[3 * t + 0] * x[a];
-        y[a] += M.offdiag[3 * t + 1] * x[c];
-        y[c] += M.offdiag[3 * t + 1] * x[a];
-        y[b] += M.offdiag[3 * t + 2] * x[c];
-        y[c] += M.offdiag[3 * t + 2] * x[b];
-        // 同时还有下三角的部分
+        for (int e = 0; e < 3; ++e)
+        {
+            A.offdiag[e * ntri + t] = val * M.offdiag[e * mstride + t] + S.offdiag[e * sstride + t];
+        }
     }
 }
 
@@ -112,14 +191,15 @@ void FEMatrix::print() const
         }
         else if (femtype == P1_Stiffness)
         {
-            dense_matrix[a][b] += offdiag[3 * t + 0];
-            dense_matrix[a][c] += offdiag[3 * t + 1];
-            dense_matrix[b][c] += offdiag[3 * t + 2];
+            size_t ntri = m.triangle_count();
+            dense_matrix[a][b] += offdiag[t];
+            dense_matrix[a][c] += offdiag[ntri + t];
+            dense_matrix[b][c] += offdiag[2 * ntri + t];
 
             // 对称矩阵，填充反向项
-            dense_matrix[b][a] += offdiag[3 * t + 0];
-            dense_matrix[c][a] += offdiag[3 * t + 1];
-            dense_matrix[c][b] += offdiag[3 * t + 2];
+            dense_matrix[b][a] += offdiag[t];
+            dense_matrix[c][a] += offdiag[ntri + t];
+            dense_matrix[c][b] += offdiag[2 * ntri + t];
         }
     }
 
@@ -0,0 +1,84 @@
+#include <LinearCombinationMatrix.h>
+#include <CSRMatrix.h>
+#include <stdexcept>
+
+LinearCombinationMatrix::LinearCombinationMatrix(const CSRMatrix &M, const CSRMatrix &S, double alpha, double beta)
+    : Matrix(M.rows, M.cols), M(M), S(S), alpha(alpha), beta(beta)
+{
+    if (M.pattern != S.pattern)
+    {
+        throw std::invalid_argument("LinearCombinationMatrix: M and S must share the same CSRPattern.");
+    }
+}
+
+void LinearCombinationMatrix::MVP(const Vec &x, Vec &y) const
+// 与CSRMatrix::MVP相同，每一行只由一个线程写入一次
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const uint32_t *offset = M.row_offset.data;
+    const uint32_t *idx = M.elm_idx.data;
+    const double *mv = M.elements.data;
+    const double *sv = S.elements.data;
+    const double *xd = x.data;
+    double *yd = y.data;
+    const double a = alpha, b = beta;
+
+#pragma omp parallel for schedule(static)
+    for (int r = 0; r < rows; ++r)
+    {
+        double sum = 0.0;
+        for (uint32_t i = offset[r]; i < offset[r + 1]; ++i)
+        {
+            sum += (a * mv[i] + b * sv[i]) * xd[idx[i]];
+        }
+        yd[r] = sum;
+    }
+}
+
+double LinearCombinationMatrix::MVP_dot(const Vec &x, Vec &y) const
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const uint32_t *offset = M.row_offset.data;
+    const uint32_t *idx = M.elm_idx.data;
+    const double *mv = M.elements.data;
+    const double *sv = S.elements.data;
+    const double *xd = x.data;
+    double *yd = y.data;
+    const double a = alpha, b = beta;
+
+    double xy = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : xy)
+    for (int r = 0; r < rows; ++r)
+    {
+        double sum = 0.0;
+        for (uint32_t i = offset[r]; i < offset[r + 1]; ++i)
+        {
+            sum += (a * mv[i] + b * sv[i]) * xd[idx[i]];
+        }
+        yd[r] = sum;
+        xy += sum * xd[r];
+    }
+    return xy;
+}
+
+void LinearCombinationMatrix::assemble(CSRMatrix &A) const
+{
+    if (A.elements.size != M.elements.size)
+    {
+        throw std::invalid_argument("Size mismatch: LinearCombinationMatrix::assemble requires the pattern of M.");
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < A.elements.size; ++t)
+    {
+        A.elements[t] = alpha * M.elements[t] + beta * S.elements[t];
+    }
+}
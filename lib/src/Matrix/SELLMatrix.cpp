@@ -0,0 +1,159 @@
+#include <SELLMatrix.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+SELLMatrix::SELLMatrix(const CSRMatrix &A, int sigma)
+    : Matrix(A.rows, A.cols), sigma(std::max(sigma, 1))
+{
+    nchunks = (rows + C - 1) / C;
+
+    // 在每sigma行的窗口内按行长度从大到小排序
+    std::vector<uint32_t> order(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        order[i] = i;
+    }
+    if (this->sigma > 1)
+    {
+        for (int w = 0; w < rows; w += this->sigma)
+        {
+            auto first = order.begin() + w;
+            auto last = order.begin() + std::min(w + this->sigma, rows);
+            std::stable_sort(first, last, [&](uint32_t a, uint32_t b)
+                             { return A.row_offset[a + 1] - A.row_offset[a] > A.row_offset[b + 1] - A.row_offset[b]; });
+        }
+        row_perm.resize(rows);
+        std::copy(order.begin(), order.end(), row_perm.begin());
+    }
+
+    chunk_offset.resize(nchunks + 1);
+    chunk_width.resize(nchunks);
+    chunk_offset[0] = 0;
+    for (int k = 0; k < nchunks; ++k)
+    {
+        uint32_t width = 0;
+        for (int lane = 0; lane < C && k * C + lane < rows; ++lane)
+        {
+            uint32_t r = order[k * C + lane];
+            width = std::max(width, A.row_offset[r + 1] - A.row_offset[r]);
+        }
+        chunk_width[k] = width;
+        chunk_offset[k + 1] = chunk_offset[k] + C * width;
+    }
+
+    size_t total = chunk_offset[nchunks];
+    col_idx.resize(total);
+    values.resize(total);
+    csr_pos.resize(total);
+
+#pragma omp parallel for
+    for (int k = 0; k < nchunks; ++k)
+    {
+        uint32_t base = chunk_offset[k];
+        for (int lane = 0; lane < C; ++lane)
+        {
+            int i = k * C + lane;
+            uint32_t r = (i < rows) ? order[i] : 0;
+            uint32_t start = (i < rows) ? A.row_offset[r] : 0;
+            uint32_t len = (i < rows) ? A.row_offset[r + 1] - start : 0;
+            for (uint32_t j = 0; j < chunk_width[k]; ++j)
+            {
+                uint32_t dst = base + j * C + lane;
+                if (j < len)
+                {
+                    col_idx[dst] = A.elm_idx[start + j];
+                    csr_pos[dst] = start + j;
+                }
+                else
+                {
+                    col_idx[dst] = r; // 补零，读取一个已经在缓存中的位置
+                    csr_pos[dst] = UINT32_MAX;
+                }
+            }
+        }
+    }
+
+    update(A);
+}
+
+void SELLMatrix::update(const CSRMatrix &A)
+{
+    if (A.rows != rows || A.cols != cols)
+    {
+        throw std::invalid_argument("Size mismatch: SELLMatrix::update requires the same pattern as the constructor.");
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < values.size; ++t)
+    {
+        values[t] = (csr_pos[t] == UINT32_MAX) ? 0.0 : A.elements[csr_pos[t]];
+    }
+}
+
+void SELLMatrix::update(const CSRMatrix &A, double alpha, const CSRMatrix &B, double beta)
+{
+    if (A.rows != rows || A.cols != cols || A.elements.size != B.elements.size)
+    {
+        throw std::invalid_argument("Size mismatch: SELLMatrix::update requires the same pattern as the constructor.");
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < values.size; ++t)
+    {
+        values[t] = (csr_pos[t] == UINT32_MAX) ? 0.0 : alpha * A.elements[csr_pos[t]] + beta * B.elements[csr_pos[t]];
+    }
+}
+
+void SELLMatrix::MVP(const Vec &x, Vec &y) const
+// 每个分片计算C行，内层对C行向量化
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const uint32_t *idx = col_idx.data;
+    const double *val = values.data;
+    const uint32_t *offset = chunk_offset.data;
+    const uint32_t *width = chunk_width.data;
+    const uint32_t *perm = row_perm.data;
+    const double *xd = x.data;
+    double *yd = y.data;
+
+#pragma omp parallel for schedule(static)
+    for (int k = 0; k < nchunks; ++k)
+    {
+        double sum[C] = {0.0};
+        const uint32_t *ck = idx + offset[k];
+        const double *vk = val + offset[k];
+        const uint32_t wk = width[k];
+        for (uint32_t j = 0; j < wk; ++j, ck += C, vk += C)
+        {
+#pragma omp simd
+            for (int lane = 0; lane < C; ++lane)
+            {
+                sum[lane] += vk[lane] * xd[ck[lane]];
+            }
+        }
+
+        int count = std::min(C, rows - k * C);
+        for (int lane = 0; lane < count; ++lane)
+        {
+            int i = k * C + lane;
+            yd[perm ? perm[i] : i] = sum[lane];
+        }
+    }
+}
+
+double SELLMatrix::fillRatio() const
+{
+    size_t nnz = 0;
+    for (size_t t = 0; t < csr_pos.size; ++t)
+    {
+        nnz += (csr_pos[t] != UINT32_MAX);
+    }
+    return (double)values.size / nnz;
+}
@@ -0,0 +1,225 @@
+#include <StencilMatrix.h>
+#include <CSRMatrix.h>
+#include <Mesh.h>
+#include <TArray.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// 第r行中第c列元素在CSR中的位置，不存在时返回UINT32_MAX
+static uint32_t findPos(const CSRMatrix &A, uint32_t r, uint32_t c)
+{
+    const uint32_t *first = A.elm_idx.data + A.row_offset[r];
+    const uint32_t *last = A.elm_idx.data + A.row_offset[r + 1];
+    const uint32_t *it = std::lower_bound(first, last, c);
+    return (it != last && *it == c) ? (uint32_t)(it - A.elm_idx.data) : UINT32_MAX;
+}
+
+StencilMatrix::StencilMatrix(const Mesh &mesh, const CSRMatrix &A)
+    : Matrix(A.rows, A.cols), n(mesh.subdiv + 1), m(std::max(0, mesh.subdiv - 3)), diag{}
+{
+    if (!mesh.dupToNoDupIndex)
+    {
+        throw std::invalid_argument("StencilMatrix: mesh must be created with saveDTND = true.");
+    }
+    if (A.rows != A.cols || (size_t)A.rows != mesh.vertex_count())
+    {
+        throw std::invalid_argument("StencilMatrix: matrix size does not match the mesh.");
+    }
+
+    const int *dtnd = mesh.dupToNoDupIndex;
+    auto vid = [&](int f, int i, int j) -> uint32_t
+    { return dtnd[((size_t)f * n + i) * n + j]; };
+
+    // 检查每个面内部的点按行连续编号，核心点的模板才能不用下标
+    for (int f = 0; f < 6 && m > 0; ++f)
+    {
+        for (int i = 1; i <= n - 2; ++i)
+        {
+            for (int j = 1; j < n - 2; ++j)
+            {
+                if (vid(f, i, j + 1) != vid(f, i, j) + 1)
+                {
+                    throw std::runtime_error("StencilMatrix: face interior vertices are not numbered row by row.");
+                }
+            }
+        }
+    }
+
+    std::vector<char> core(rows, 0);
+    row_base.resize(6 * m);
+    up_base.resize(6 * m);
+    down_base.resize(6 * m);
+    for (int f = 0; f < 6 && m > 0; ++f)
+    {
+        // 由第一个核心点的非零结构确定这个面的对角线方向
+        uint32_t v = vid(f, 2, 2);
+        if (findPos(A, v, vid(f, 3, 3)) != UINT32_MAX && findPos(A, v, vid(f, 1, 1)) != UINT32_MAX)
+        {
+            diag[f] = 1;
+        }
+        else if (findPos(A, v, vid(f, 3, 1)) != UINT32_MAX && findPos(A, v, vid(f, 1, 3)) != UINT32_MAX)
+        {
+            diag[f] = -1;
+        }
+        else
+        {
+            throw std::invalid_argument("StencilMatrix: pattern is not a 7-point stencil on the cube faces.");
+        }
+
+        for (int i = 2; i <= n - 3; ++i)
+        {
+            row_base[f * m + i - 2] = vid(f, i, 2);
+            up_base[f * m + i - 2] = vid(f, i + 1, 2);
+            down_base[f * m + i - 2] = vid(f, i - 1, 2);
+            for (int j = 2; j <= n - 3; ++j)
+            {
+                core[vid(f, i, j)] = 1;
+            }
+        }
+    }
+
+    // 核心点的系数在原CSR中的位置
+    size_t ncore = coreRows();
+    size_t mm = (size_t)m * m;
+    csr_pos.resize(7 * ncore);
+    bool missing = false;
+
+#pragma omp parallel for reduction(|| : missing)
+    for (int r = 0; r < 6 * m; ++r)
+    {
+        int f = r / m, i = r % m + 2;
+        int d = diag[f];
+        const int di[7] = {0, 0, 0, -1, 1, -1, 1};
+        const int dj[7] = {0, -1, 1, 0, 0, -d, d};
+        for (int j = 2; j <= n - 3; ++j)
+        {
+            uint32_t v = vid(f, i, j);
+            missing = missing || A.row_offset[v + 1] - A.row_offset[v] != 7;
+            for (int k = 0; k < 7; ++k)
+            {
+                uint32_t pos = findPos(A, v, vid(f, i + di[k], j + dj[k]));
+                missing = missing || pos == UINT32_MAX;
+                csr_pos[(f * 7 + k) * mm + (size_t)(i - 2) * m + (j - 2)] = pos;
+            }
+        }
+    }
+
+    if (missing)
+    {
+        throw std::invalid_argument("StencilMatrix: pattern is not a 7-point stencil on the cube faces.");
+    }
+
+    // 其余的行按CSR存储
+    seam_row.resize(rows - ncore);
+    seam_offset.resize(seam_row.size + 1);
+    seam_offset[0] = 0;
+    size_t k = 0;
+    for (int r = 0; r < rows; ++r)
+    {
+        if (!core[r])
+        {
+            seam_row[k] = r;
+            seam_offset[k + 1] = seam_offset[k] + (A.row_offset[r + 1] - A.row_offset[r]);
+            ++k;
+        }
+    }
+
+    size_t nseam = seam_offset[seam_row.size];
+    seam_idx.resize(nseam);
+    csr_pos.resize(7 * ncore + nseam);
+#pragma omp parallel for
+    for (size_t s = 0; s < seam_row.size; ++s)
+    {
+        uint32_t r = seam_row[s];
+        for (uint32_t i = 0; i < seam_offset[s + 1] - seam_offset[s]; ++i)
+        {
+            seam_idx[seam_offset[s] + i] = A.elm_idx[A.row_offset[r] + i];
+            csr_pos[7 * ncore + seam_offset[s] + i] = A.row_offset[r] + i;
+        }
+    }
+
+    values.resize(csr_pos.size);
+    update(A);
+}
+
+void StencilMatrix::update(const CSRMatrix &A)
+{
+    if (A.rows != rows || A.cols != cols)
+    {
+        throw std::invalid_argument("Size mismatch: StencilMatrix::update requires the same pattern as the constructor.");
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < values.size; ++t)
+    {
+        values[t] = A.elements[csr_pos[t]];
+    }
+}
+
+void StencilMatrix::update(const CSRMatrix &A, double alpha, const CSRMatrix &B, double beta)
+{
+    if (A.rows != rows || A.cols != cols || A.elements.size != B.elements.size)
+    {
+        throw std::invalid_argument("Size mismatch: StencilMatrix::update requires the same pattern as the constructor.");
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < values.size; ++t)
+    {
+        values[t] = alpha * A.elements[csr_pos[t]] + beta * B.elements[csr_pos[t]];
+    }
+}
+
+void StencilMatrix::MVP(const Vec &x, Vec &y) const
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const size_t mm = (size_t)m * m;
+    const double *val = values.data;
+    const double *seam_val = values.data + 7 * coreRows();
+    const uint32_t *offset = seam_offset.data;
+    const uint32_t *idx = seam_idx.data;
+    const uint32_t *srow = seam_row.data;
+    const size_t nseam = seam_row.size;
+    const double *xd = x.data;
+    double *yd = y.data;
+
+#pragma omp parallel
+    {
+        // 核心行与CSR部分写入的y互不相交，不需要同步
+#pragma omp for schedule(static) nowait
+        for (int r = 0; r < 6 * m; ++r)
+        {
+            int f = r / m;
+            int d = diag[f];
+            const double *c = val + (size_t)f * 7 * mm + (size_t)(r % m) * m;
+            const double *c0 = c, *cw = c + mm, *ce = c + 2 * mm, *cs = c + 3 * mm;
+            const double *cn = c + 4 * mm, *csd = c + 5 * mm, *cnd = c + 6 * mm;
+            const double *x0 = xd + row_base[r];
+            const double *xs = xd + down_base[r];
+            const double *xn = xd + up_base[r];
+            double *y0 = yd + row_base[r];
+
+#pragma omp simd
+            for (int j = 0; j < m; ++j)
+            {
+                y0[j] = c0[j] * x0[j] + cw[j] * x0[j - 1] + ce[j] * x0[j + 1] + cs[j] * xs[j] + cn[j] * xn[j] + csd[j] * xs[j - d] + cnd[j] * xn[j + d];
+            }
+        }
+
+#pragma omp for schedule(static)
+        for (size_t s = 0; s < nseam; ++s)
+        {
+            double sum = 0.0;
+            for (uint32_t i = offset[s]; i < offset[s + 1]; ++i)
+            {
+                sum += seam_val[i] * xd[idx[i]];
+            }
+            yd[srow[s]] = sum;
+        }
+    }
+}
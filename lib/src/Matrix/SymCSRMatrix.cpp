@@ -0,0 +1,246 @@
+#include <SymCSRMatrix.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <omp.h>
+
+// 第r行中第一个列下标不小于r的元素，即对角元在CSR中的位置
+static uint32_t diagPos(const CSRMatrix &A, uint32_t r)
+{
+    const uint32_t *first = A.elm_idx.data + A.row_offset[r];
+    const uint32_t *last = A.elm_idx.data + A.row_offset[r + 1];
+    return A.row_offset[r] + (std::lower_bound(first, last, r) - first);
+}
+
+SymCSRMatrix::SymCSRMatrix(const CSRMatrix &A, int parts)
+    : Matrix(A.rows, A.cols), row_offset(A.rows + 1, 0)
+{
+    if (A.rows != A.cols)
+    {
+        throw std::invalid_argument("SymCSRMatrix: matrix must be square.");
+    }
+
+    for (int r = 0; r < rows; ++r)
+    {
+        uint32_t d = diagPos(A, r);
+        if (d == A.row_offset[r + 1] || A.elm_idx[d] != (uint32_t)r)
+        {
+            throw std::invalid_argument("SymCSRMatrix: missing diagonal element.");
+        }
+        row_offset[r + 1] = row_offset[r] + (A.row_offset[r + 1] - d);
+    }
+
+    elm_idx.resize(row_offset[rows]);
+    elements.resize(row_offset[rows]);
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r)
+    {
+        uint32_t d = diagPos(A, r);
+        std::copy(A.elm_idx.begin() + d, A.elm_idx.begin() + A.row_offset[r + 1], elm_idx.begin() + row_offset[r]);
+    }
+
+    partition(parts > 0 ? parts : omp_get_max_threads());
+    update(A);
+}
+
+void SymCSRMatrix::partition(int parts)
+{
+    nparts = std::max(1, std::min(parts, rows));
+    part_row.resize(nparts + 1);
+    part_col_end.resize(nparts);
+    window_offset.resize(nparts + 1);
+
+    // 每段的非零元数量大致相同
+    size_t nnz = row_offset[rows];
+    part_row[0] = 0;
+    for (int p = 1; p < nparts; ++p)
+    {
+        size_t target = nnz * p / nparts;
+        uint32_t r = std::upper_bound(row_offset.begin(), row_offset.end(), target) - row_offset.begin() - 1;
+        part_row[p] = std::max(part_row[p - 1], std::min(r, (uint32_t)rows));
+    }
+    part_row[nparts] = rows;
+
+    // 窗口为 [段尾, 段尾 + 本段元素数 / WindowRatio) 中实际出现的最大列下标 + 1，之外的元素记为远处元素
+    std::vector<uint32_t> far_count(nparts + 1, 0);
+    window_offset[0] = 0;
+    for (int p = 0; p < nparts; ++p)
+    {
+        uint32_t r1 = part_row[p + 1];
+        uint32_t limit = r1 + (uint32_t)std::min<size_t>((row_offset[r1] - row_offset[part_row[p]]) / WindowRatio, rows - r1);
+        uint32_t end = r1;
+        for (uint32_t i = row_offset[part_row[p]]; i < row_offset[r1]; ++i)
+        {
+            uint32_t c = elm_idx[i];
+            if (c >= limit)
+            {
+                far_count[std::upper_bound(part_row.begin(), part_row.end(), c) - part_row.begin()] += 1;
+            }
+            else if (c >= end)
+            {
+                end = c + 1;
+            }
+        }
+        part_col_end[p] = end;
+        window_offset[p + 1] = window_offset[p] + (end - r1);
+    }
+    window.resize(window_offset[nparts]);
+
+    // 远处元素按列所在的段分组，far_offset[q]开始为第q段
+    far_offset.resize(nparts + 1);
+    far_offset[0] = 0;
+    for (int q = 0; q < nparts; ++q)
+    {
+        far_offset[q + 1] = far_offset[q] + far_count[q + 1];
+    }
+    far_row.resize(far_offset[nparts]);
+    far_pos.resize(far_offset[nparts]);
+    std::vector<uint32_t> next(far_offset.begin(), far_offset.end() - 1);
+    for (int p = 0; p < nparts; ++p)
+    {
+        for (uint32_t r = part_row[p]; r < part_row[p + 1]; ++r)
+        {
+            for (uint32_t i = row_offset[r]; i < row_offset[r + 1]; ++i)
+            {
+                if (elm_idx[i] >= part_col_end[p]) // part_col_end[p] >= part_row[p + 1]
+                {
+                    int q = std::upper_bound(part_row.begin(), part_row.end(), elm_idx[i]) - part_row.begin() - 1;
+                    far_row[next[q]] = r;
+                    far_pos[next[q]] = i;
+                    ++next[q];
+                }
+            }
+        }
+    }
+}
+
+template <typename Value>
+void SymCSRMatrix::multiply(const Vec &x, Vec &y, Value val) const
+{
+    if (cols != x.size || rows != y.size)
+    {
+        throw std::invalid_argument("Size mismatch: The number of columns in the matrix does not match the size of the vector.");
+    }
+
+    const uint32_t *offset = row_offset.data;
+    const uint32_t *idx = elm_idx.data;
+    const double *xd = x.data;
+    double *yd = y.data;
+    double *wd = window.data;
+
+#pragma omp parallel
+    {
+#pragma omp for schedule(static, 1)
+        for (int p = 0; p < nparts; ++p)
+        {
+            uint32_t r0 = part_row[p], r1 = part_row[p + 1], end = part_col_end[p];
+            double *w = wd + window_offset[p] - r1; // w[j]对应第j列，r1 <= j < end
+            std::fill(yd + r0, yd + r1, 0.0);
+            std::fill(w + r1, w + end, 0.0);
+
+            for (uint32_t r = r0; r < r1; ++r)
+            {
+                double xr = xd[r];
+                double sum = val(offset[r]) * xr; // 对角元
+                for (uint32_t i = offset[r] + 1; i < offset[r + 1]; ++i)
+                {
+                    uint32_t c = idx[i];
+                    double a = val(i);
+                    sum += a * xd[c];
+                    if (c < r1)
+                    {
+                        yd[c] += a * xr;
+                    }
+                    else if (c < end)
+                    {
+                        w[c] += a * xr;
+                    }
+                }
+                yd[r] += sum;
+            }
+        }
+
+        // 隐式同步后，每段累加之前各段的窗口中落在本段内的部分与列在本段内的远处元素，每个y[c]只由一个线程写入
+#pragma omp for schedule(static, 1)
+        for (int q = 0; q < nparts; ++q)
+        {
+            uint32_t r0 = part_row[q], r1 = part_row[q + 1];
+            for (int p = 0; p < q; ++p)
+            {
+                const double *w = wd + window_offset[p] - part_row[p + 1];
+                uint32_t c1 = std::min(r1, part_col_end[p]);
+                for (uint32_t c = r0; c < c1; ++c)
+                {
+                    yd[c] += w[c];
+                }
+            }
+            for (uint32_t k = far_offset[q]; k < far_offset[q + 1]; ++k)
+            {
+                uint32_t i = far_pos[k];
+                yd[idx[i]] += val(i) * xd[far_row[k]];
+            }
+        }
+    }
+}
+
+void SymCSRMatrix::update(const CSRMatrix &A)
+{
+    extract(A, elements);
+}
+
+void SymCSRMatrix::extract(const CSRMatrix &A, Vec &values) const
+{
+    if (A.rows != rows || A.cols != cols || A.elements.size != 2 * elements.size - rows)
+    {
+        throw std::invalid_argument("Size mismatch: SymCSRMatrix requires the same pattern as the constructor.");
+    }
+
+    values.resize(elements.size);
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r)
+    {
+        uint32_t d = diagPos(A, r);
+        std::copy(A.elements.begin() + d, A.elements.begin() + A.row_offset[r + 1], values.begin() + row_offset[r]);
+    }
+}
+
+void SymCSRMatrix::MVP(const Vec &x, Vec &y) const
+{
+    const double *v = elements.data;
+    multiply(x, y, [v](uint32_t i) { return v[i]; });
+}
+
+void SymCSRMatrix::combinedMVP(const Vec &x, Vec &y, double alpha, const Vec &other, double beta) const
+{
+    if (other.size != elements.size)
+    {
+        throw std::invalid_argument("Size mismatch: SymCSRMatrix::combinedMVP requires values in the same pattern.");
+    }
+    const double *a = elements.data;
+    const double *b = other.data;
+    multiply(x, y, [a, b, alpha, beta](uint32_t i) { return alpha * a[i] + beta * b[i]; });
+}
+
+double SymCSRMatrix::operator()(size_t i, size_t j) const
+{
+    if (i > j)
+    {
+        std::swap(i, j);
+    }
+    const uint32_t *first = elm_idx.data + row_offset[i];
+    const uint32_t *last = elm_idx.data + row_offset[i + 1];
+    const uint32_t *it = std::lower_bound(first, last, (uint32_t)j);
+    return (it != last && *it == j) ? elements[it - elm_idx.data] : 0.0;
+}
+
+void blas_addMatrix(const SymCSRMatrix &M, double val, const SymCSRMatrix &S, SymCSRMatrix &A)
+// 计算A = val * M + S
+{
+#pragma omp parallel for
+    for (size_t t = 0; t < A.elements.size; ++t)
+    {
+        A.elements[t] = M.elements[t] * val + S.elements[t];
+    }
+}
@@ -5,6 +5,9 @@
 // #include <timer.h>
 // #include <iostream>
 #include <unordered_map>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
 
 /* 生成立方体网格, 中心为原点，边长为2
  * 对于有n个子分割的网格
@@ -394,4 +397,99 @@ Mesh::~Mesh()
         delete[] dupToNoDupIndex;
         dupToNoDupIndex = nullptr;
     }
-}
\ No newline at end of file
+}
+static bool colorBlocks(const Mesh &m, size_t bs, std::vector<uint8_t> &color, std::vector<uint32_t> &count)
+/* 每个顶点记录已经出现在其周围的颜色(64位掩码)
+ * 块可用的颜色为块内所有顶点掩码之外的颜色，从中选择当前块最少的一种，没有可用颜色时增加一种
+ * 三角形按行生成时，一个块只与前后相邻的少数几个块共享顶点，颜色数量远小于64；超过64种时返回false
+ */
+{
+    size_t ntri = m.triangle_count();
+    size_t nblocks = (ntri + bs - 1) / bs;
+    std::vector<uint64_t> used(m.vertex_count(), 0);
+    color.assign(nblocks, 0);
+    count.clear();
+
+    for (size_t b = 0; b < nblocks; ++b)
+    {
+        size_t begin = 3 * b * bs;
+        size_t end = std::min(3 * ntri, begin + 3 * bs);
+        uint64_t forbidden = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            forbidden |= used[m.indices[i]];
+        }
+
+        int best = -1;
+        for (int k = 0; k < (int)count.size(); ++k)
+        {
+            if (!(forbidden >> k & 1) && (best < 0 || count[k] < count[best]))
+            {
+                best = k;
+            }
+        }
+        if (best < 0)
+        {
+            if (count.size() == 64)
+            {
+                return false;
+            }
+            best = count.size();
+            count.push_back(0);
+        }
+
+        color[b] = best;
+        count[best] += 1;
+        for (size_t i = begin; i < end; ++i)
+        {
+            used[m.indices[i]] |= uint64_t(1) << best;
+        }
+    }
+    return true;
+}
+
+bool Mesh::buildColoring(int blockSize)
+// 从blockSize开始，颜色不够时块大小减半，直到逐个三角形着色
+{
+    std::vector<uint8_t> color;
+    std::vector<uint32_t> count;
+    int bs = std::max(blockSize, 1);
+    while (!colorBlocks(*this, bs, color, count))
+    {
+        if (bs == 1)
+        {
+            color_offset.resize(0);
+            color_block.resize(0);
+            coloring_failed = true;
+            return false;
+        }
+        bs /= 2;
+    }
+    color_block_size = bs;
+    coloring_failed = false;
+    size_t nblocks = color.size();
+
+    // 按颜色进行计数排序
+    color_offset.resize(count.size() + 1);
+    color_offset[0] = 0;
+    for (size_t k = 0; k < count.size(); ++k)
+    {
+        color_offset[k + 1] = color_offset[k] + count[k];
+    }
+    std::vector<uint32_t> pos(color_offset.begin(), color_offset.end() - 1);
+    color_block.resize(nblocks);
+    for (size_t b = 0; b < nblocks; ++b)
+    {
+        color_block[pos[color[b]]++] = b;
+    }
+    return true;
+}
+
+bool Mesh::ensureColoring()
+{
+    if (color_offset.size == 0 && !coloring_failed)
+    {
+        buildColoring();
+    }
+    return color_offset.size > 0;
+}
@@ -0,0 +1,368 @@
+#include <amg.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <cholesky.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// 对角元，缺失时为0
+static double diagonal(const CSRMatrix &A, int r)
+{
+    const uint32_t *first = A.elm_idx.data + A.row_offset[r];
+    const uint32_t *last = A.elm_idx.data + A.row_offset[r + 1];
+    const uint32_t *it = std::lower_bound(first, last, (uint32_t)r);
+    return (it != last && *it == (uint32_t)r) ? A.elements[it - A.elm_idx.data] : 0.0;
+}
+
+// 打乱行号作为MIS的优先级，避免按编号顺序选出条带状的聚合
+static uint32_t hashRow(uint32_t x)
+{
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+}
+
+static void strongConnections(const CSRMatrix &A, double theta, std::vector<char> &strong)
+// strong[k] 表示A中第k个元素是否为强连接，对角元不计入
+{
+    int n = A.rows;
+    std::vector<double> d(n);
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        d[r] = std::abs(diagonal(A, r));
+    }
+
+    strong.assign(A.elements.size, 0);
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        for (uint32_t k = A.row_offset[r]; k < A.row_offset[r + 1]; ++k)
+        {
+            uint32_t c = A.elm_idx[k];
+            strong[k] = c != (uint32_t)r && std::abs(A.elements[k]) >= theta * std::sqrt(d[r] * d[c]);
+        }
+    }
+}
+
+static int aggregate(const CSRMatrix &A, const std::vector<char> &strong, TArray<uint32_t> &agg)
+/* 返回聚合的个数
+ * MIS-2: 每个点的键为 (状态, 哈希, 行号)，状态 中心 > 未定 > 排除
+ * 每一轮求出距离2以内的最大键，未定的点若自己就是最大值则成为中心，若最大值为中心则被排除
+ */
+{
+    const int n = A.rows;
+    const uint64_t IN = 2, UNDECIDED = 1, OUT = 0;
+    std::vector<uint8_t> state(n, UNDECIDED);
+    std::vector<uint64_t> key(n), m1(n);
+
+    auto maxNeighbour = [&](const std::vector<uint64_t> &src, int r)
+    {
+        uint64_t m = src[r];
+        for (uint32_t k = A.row_offset[r]; k < A.row_offset[r + 1]; ++k)
+        {
+            if (strong[k])
+                m = std::max(m, src[A.elm_idx[k]]);
+        }
+        return m;
+    };
+
+    int undecided = n;
+    while (undecided > 0)
+    {
+#pragma omp parallel for
+        for (int r = 0; r < n; ++r)
+        {
+            key[r] = ((uint64_t)state[r] << 62) | ((uint64_t)(hashRow(r) & 0x3fffffff) << 32) | (uint64_t)r;
+        }
+#pragma omp parallel for
+        for (int r = 0; r < n; ++r)
+        {
+            m1[r] = maxNeighbour(key, r);
+        }
+        undecided = 0;
+#pragma omp parallel for reduction(+ : undecided)
+        for (int r = 0; r < n; ++r)
+        {
+            if (state[r] != UNDECIDED)
+                continue;
+            uint64_t m2 = maxNeighbour(m1, r);
+            if (m2 == key[r])
+                state[r] = IN;
+            else if ((m2 >> 62) == IN)
+                state[r] = OUT;
+            else
+                ++undecided;
+        }
+    }
+
+    // 中心按行号顺序编号
+    agg.resize(n);
+    int nagg = 0;
+    for (int r = 0; r < n; ++r)
+    {
+        agg[r] = (state[r] == IN) ? nagg++ : UINT32_MAX;
+    }
+
+    // 第一步: 加入最强的相邻中心的聚合，只读取中心的编号
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        if (state[r] == IN)
+            continue;
+        double best = -1.0;
+        for (uint32_t k = A.row_offset[r]; k < A.row_offset[r + 1]; ++k)
+        {
+            uint32_t c = A.elm_idx[k];
+            if (strong[k] && state[c] == IN && std::abs(A.elements[k]) > best)
+            {
+                best = std::abs(A.elements[k]);
+                agg[r] = agg[c];
+            }
+        }
+    }
+
+    // 第二步: 加入最强的、在第一步中已聚合的邻点的聚合
+    TArray<uint32_t> first = agg;
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        if (first[r] != UINT32_MAX)
+            continue;
+        double best = -1.0;
+        for (uint32_t k = A.row_offset[r]; k < A.row_offset[r + 1]; ++k)
+        {
+            uint32_t c = A.elm_idx[k];
+            if (strong[k] && first[c] != UINT32_MAX && std::abs(A.elements[k]) > best)
+            {
+                best = std::abs(A.elements[k]);
+                agg[r] = first[c];
+            }
+        }
+    }
+    return nagg;
+}
+
+static CSRMatrix smoothedProlongation(const CSRMatrix &A, const TArray<uint32_t> &agg, int nagg)
+// P = (I - omega D^{-1} A) P0，P的结构与 A P0 相同
+{
+    int n = A.rows;
+    auto pattern = std::make_shared<CSRPattern>(n);
+    pattern->elm_idx.resize(n);
+    for (int r = 0; r < n; ++r)
+    {
+        pattern->row_offset[r + 1] = r + 1;
+    }
+    CSRMatrix P0(n, nagg, pattern);
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        pattern->elm_idx[r] = agg[r];
+        P0.elements[r] = 1.0;
+    }
+
+    // rho(D^{-1} A) 的Gershgorin上界
+    double rho = 0.0;
+#pragma omp parallel for reduction(max : rho)
+    for (int r = 0; r < n; ++r)
+    {
+        double s = 0.0;
+        for (uint32_t k = A.row_offset[r]; k < A.row_offset[r + 1]; ++k)
+        {
+            s += std::abs(A.elements[k]);
+        }
+        rho = std::max(rho, s / std::abs(diagonal(A, r)));
+    }
+    double omega = 4.0 / 3.0 / rho;
+
+    CSRMatrix P = multiply(A, P0);
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        double s = omega / diagonal(A, r);
+        for (uint32_t k = P.row_offset[r]; k < P.row_offset[r + 1]; ++k)
+        {
+            P.elements[k] = (P.elm_idx[k] == agg[r] ? 1.0 : 0.0) - s * P.elements[k];
+        }
+    }
+    return P;
+}
+
+AMGPreconditioner::AMGPreconditioner(const CSRMatrix &A, double theta, int coarseSize, int maxLevels)
+    : theta(theta), coarseSize(std::max(coarseSize, 1)), maxLevels(std::max(maxLevels, 1)), w(0.6), smooth(2)
+{
+    coarse.setOrdering(Cholesky::RCM);
+    setup(A);
+}
+
+void AMGPreconditioner::setup(const CSRMatrix &A)
+{
+    if (A.rows != A.cols)
+    {
+        throw std::invalid_argument("AMGPreconditioner: matrix must be square.");
+    }
+    for (int r = 0; r < A.rows; ++r)
+    {
+        if (diagonal(A, r) == 0.0)
+        {
+            throw std::invalid_argument("AMGPreconditioner: zero or missing diagonal element.");
+        }
+    }
+
+    levels.clear();
+    levels.emplace_back();
+    levels[0].A = &A;
+    pattern = A.pattern;
+
+    while ((int)levels.size() < maxLevels && levels.back().A->rows > coarseSize)
+    {
+        Level &L = levels.back();
+        std::vector<char> strong;
+        strongConnections(*L.A, theta, strong);
+        int nagg = aggregate(*L.A, strong, L.aggregate);
+        if (nagg == 0 || nagg > 0.8 * L.A->rows) // 粗化太慢，继续下去得不偿失
+        {
+            break;
+        }
+
+        L.P.reset(new CSRMatrix(smoothedProlongation(*L.A, L.aggregate, nagg)));
+        L.R.reset(new CSRMatrix(transpose(*L.P)));
+        CSRMatrix *Ac = new CSRMatrix(tripleProduct(*L.R, *L.A, *L.P));
+
+        levels.emplace_back();
+        levels.back().owned.reset(Ac);
+        levels.back().A = Ac;
+    }
+
+    // 最后一层没有插值，不需要聚合
+    levels.back().aggregate.resize(0);
+    if (levels.size() == 1) // 只有一层时分解需要可修改的矩阵，复制一份(共享非零结构)
+    {
+        levels[0].owned.reset(new CSRMatrix(A));
+    }
+
+    for (int l = 0; l < levelCount(); ++l)
+    {
+        int n = levels[l].A->rows;
+        levels[l].x = Vec(n, 0.0);
+        levels[l].b = Vec(n, 0.0);
+        levels[l].r = Vec(n, 0.0);
+        levels[l].t = Vec(n, 0.0);
+    }
+    coarse.analyze(*levels.back().owned);
+    for (int l = 0; l < levelCount(); ++l)
+    {
+        refreshLevel(l);
+    }
+}
+
+void AMGPreconditioner::update(const CSRMatrix &A)
+{
+    if (A.rows != levels[0].A->rows || A.elements.size != levels[0].A->elements.size || !samePattern(*A.pattern, *pattern))
+    {
+        throw std::invalid_argument("Size mismatch: AMGPreconditioner::update requires the same pattern as setup.");
+    }
+    levels[0].A = &A;
+    if (levels.size() == 1)
+    {
+        levels[0].owned->elements = A.elements;
+    }
+    for (int l = 0; l < levelCount(); ++l)
+    {
+        if (l > 0)
+        {
+            const Level &F = levels[l - 1];
+            tripleProductNumeric(*F.R, *F.A, *F.P, *levels[l].owned);
+        }
+        refreshLevel(l);
+    }
+}
+
+void AMGPreconditioner::refreshLevel(int l)
+{
+    Level &L = levels[l];
+    int n = L.A->rows;
+    L.invDiag.resize(n);
+    double dmax = 0.0;
+#pragma omp parallel for reduction(max : dmax)
+    for (int r = 0; r < n; ++r)
+    {
+        double d = diagonal(*L.A, r);
+        L.invDiag[r] = 1.0 / d;
+        dmax = std::max(dmax, std::abs(d));
+    }
+
+    if (l == levelCount() - 1)
+    {
+        coarse.factorize(*L.owned, 1e-12 * dmax); // 微小的偏移使只差一个常数的奇异问题也可以分解
+    }
+}
+
+static void jacobiSmooth(const CSRMatrix &A, const Vec &invDiag, const Vec &b, Vec &x, Vec &t, double w, int iter)
+// x = x + w * D^{-1} (b - Ax)
+{
+    int n = A.rows;
+    for (int k = 0; k < iter; ++k)
+    {
+        A.MVP(x, t);
+#pragma omp parallel for
+        for (int r = 0; r < n; ++r)
+        {
+            x[r] += w * invDiag[r] * (b[r] - t[r]);
+        }
+    }
+}
+
+void AMGPreconditioner::cycle(int l, const Vec &b, Vec &x) const
+// x的初值为零
+{
+    const Level &L = levels[l];
+    int n = L.A->rows;
+    if (l == levelCount() - 1)
+    {
+        L.b = b;
+        coarse.solve(L.b, x);
+        return;
+    }
+
+    // 初值为零时第一次平滑不需要MVP
+#pragma omp parallel for
+    for (int r = 0; r < n; ++r)
+    {
+        x[r] = w * L.invDiag[r] * b[r];
+    }
+    jacobiSmooth(*L.A, L.invDiag, b, x, L.t, w, smooth - 1);
+
+    L.A->MVP(x, L.t);
+    blas_axpby(1.0, b, -1.0, L.t, L.r); // 残差
+
+    const Level &C = levels[l + 1];
+    L.R->MVP(L.r, C.b);
+    cycle(l + 1, C.b, C.x);
+    L.P->MVP(C.x, L.t);
+    blas_axpby(1.0, x, 1.0, L.t, x);
+
+    jacobiSmooth(*L.A, L.invDiag, b, x, L.t, w, smooth);
+}
+
+void AMGPreconditioner::apply(const Vec &r, Vec &z) const
+{
+    if (smooth < 1) // 不平滑时V循环只作用于粗空间，P奇异
+    {
+        throw std::invalid_argument("AMGPreconditioner: smooth must be at least 1.");
+    }
+    cycle(0, r, z);
+}
+
+double AMGPreconditioner::operatorComplexity() const
+{
+    double nnz = 0.0;
+    for (const Level &L : levels)
+    {
+        nnz += L.A->elements.size;
+    }
+    return nnz / levels[0].A->elements.size;
+}
@@ -1,39 +1,248 @@
 #include <cholesky.h>
 #include <TArray.h>
 #include <CSRMatrix.h>
+#include <reorder.h>
 #include <cmath>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
 // #include <timer.h>
 
-Cholesky::Cholesky() : L(), A(), minElmIdx(), isInitialized(false) {}
+Cholesky::Cholesky() : L(), A(), minElmIdx(), isInitialized(false), ordering(Natural), perm(), envelopeBefore(0), envelopeAfter(0), taskFactor(true), parallelSolve(true), matrixHash(0), fromCache(false),
+                       singlePrecision(false), refMatrix(nullptr), refEpsilon(0.0), maxRefine(10), refineTol(1e-12), refineIter(0) {}
 
-void Cholesky::attach(CSRMatrix &A_CSR)
+void Cholesky::setSinglePrecision(bool single, int maxIter, double tol)
 {
-    L = SKRMatrix(A_CSR);
-    A = SKRMatrix(A_CSR);
-    A.convertFromCSR(A_CSR);
-    minElmIdx.resize(L.rows);
-    minElmIdx[0] = 0;
-    for (int row = 1; row < L.rows; ++row)
+    singlePrecision = single;
+    maxRefine = maxIter;
+    refineTol = tol;
+}
+
+void Cholesky::analyze(CSRMatrix &A_CSR)
+/* 符号分解，只依赖A的非零结构
+ * 若设置了重排，先求出重排P，再由A的非零结构直接得到 P A P^T 的skyline结构
+ * solve 中对b和x进行对应的重排，对调用者透明
+ */
+{
+    int n = A_CSR.rows;
+    envelopeBefore = envelopeSize(A_CSR);
+    TArray<int> iperm;
+    if (ordering != Natural)
+    {
+        if (ordering == RCM)
+        {
+            reverseCuthillMcKee(A_CSR, perm);
+        }
+        else
+        {
+            nestedDissection(A_CSR, perm);
+        }
+        pb.resize(n);
+        px.resize(n);
+        invertPermutation(perm, iperm);
+    }
+    else
     {
-        int SKR_start = L.column_offset[row];
-        int SKR_len = L.column_offset[row + 1] - SKR_start;
-        minElmIdx[row] = row - SKR_len + 1;
+        perm.resize(0);
     }
+
+    // 重排后每行最左端的非零元只依赖非零结构，不需要构造带数值的 P A P^T
+    minElmIdx.resize(n);
+#pragma omp parallel for
+    for (int prow = 0; prow < n; ++prow)
+    {
+        int row = (perm.size == 0) ? prow : perm[prow];
+        int m = prow;
+        for (size_t t = A_CSR.row_offset[row]; t < A_CSR.row_offset[row + 1]; ++t)
+        {
+            int pcol = (perm.size == 0) ? (int)A_CSR.elm_idx[t] : iperm[A_CSR.elm_idx[t]];
+            m = std::min(m, pcol);
+        }
+        minElmIdx[prow] = m;
+    }
+    buildSkyline();
+    envelopeAfter = L.column_offset[L.rows];
+    pattern = A_CSR.pattern;
+
+    // A中每个元素在skyline中的位置，上三角部分为-1
+    value_pos.resize(A_CSR.elements.size);
+#pragma omp parallel for
+    for (int row = 0; row < n; ++row)
+    {
+        int prow = (perm.size == 0) ? row : iperm[row];
+        for (size_t t = A_CSR.row_offset[row]; t < A_CSR.row_offset[row + 1]; ++t)
+        {
+            int pcol = (perm.size == 0) ? (int)A_CSR.elm_idx[t] : iperm[A_CSR.elm_idx[t]];
+            value_pos[t] = (pcol <= prow) ? L.column_offset[prow] + pcol - minElmIdx[prow] : (size_t)(-1);
+        }
+    }
+    refMatrix = nullptr;
 }
-void Cholesky::attach(CSRMatrix &A_CSR, double epsilon)
+
+void Cholesky::setValues(CSRMatrix &A_CSR, double epsilon)
+// 将A的数值写入skyline，A的非零结构需要与analyze时相同
 {
-    attach(A_CSR);
+    if (A_CSR.rows != L.rows || A_CSR.elements.size != value_pos.size || !pattern || !samePattern(*A_CSR.pattern, *pattern))
+    {
+        throw std::invalid_argument("Cholesky: matrix pattern differs from the analyzed one.");
+    }
+    // 哈希需要遍历整个矩阵，只在使用缓存时计算
+    matrixHash = cacheDir.empty() ? 0 : hashCombine(hashCombine(hashMatrix(A_CSR), (double)ordering), epsilon);
+    // 迭代改进需要原矩阵，保存一份副本(共享非零结构)，不依赖调用者的A_CSR在求解时仍然有效
+    refMatrix = singlePrecision ? std::make_shared<const CSRMatrix>(A_CSR) : nullptr;
+    refEpsilon = epsilon;
+    fromCache = false;
+    cached = CachedFactor();
+
+    size_t nnz = L.column_offset[L.rows];
+    L.elements.resize(nnz); // analyze之后或从缓存读取后elements为空
+    L.elements.setAll(0.0); // 逐列分解计算对角线时会读取L中尚未写入的对角元
+    A.elements.resize(nnz);
+    A.elements.setAll(0.0);
+#pragma omp parallel for
+    for (size_t t = 0; t < value_pos.size; ++t)
+    {
+        if (value_pos[t] != (size_t)(-1))
+        {
+            A.elements[value_pos[t]] = A_CSR.elements[t];
+        }
+    }
     for (int row = 0; row < A.rows; ++row)
     {
         A.elements[A.column_offset[row + 1] - 1] += epsilon;
     }
 }
 
+void Cholesky::attach(CSRMatrix &A_CSR)
+{
+    analyze(A_CSR);
+    setValues(A_CSR, 0.0);
+}
+
+void Cholesky::attach(CSRMatrix &A_CSR, double epsilon)
+{
+    analyze(A_CSR);
+    setValues(A_CSR, epsilon);
+}
+
+void Cholesky::factorize(CSRMatrix &A_CSR, double epsilon)
+{
+    setValues(A_CSR, epsilon);
+    compute();
+}
+
+void Cholesky::buildSkyline()
+// 由minElmIdx得到L与A的skyline结构，数值在setValues中分配，因此符号分解的结果被复制时不复制数值
+{
+    int n = minElmIdx.size;
+    L = SKRMatrix(n);
+    L.column_offset.resize(n + 1);
+    L.column_offset[0] = 0;
+    for (int row = 0; row < n; ++row)
+    {
+        L.column_offset[row + 1] = L.column_offset[row] + row - minElmIdx[row] + 1;
+    }
+    A = SKRMatrix(n);
+    A.column_offset = L.column_offset;
+    y.resize(n);
+    diag_elements.resize(n);
+
+    /* 消去树: 第i行的包络 [minElmIdx[i], i) 中的行都是i的后代
+     * 若 minElmIdx[j + 1] <= j 则 parent[j] = j + 1，因此只有 minElmIdx[i] == i 的行之前会断开
+     * 对于这样断开的行j，用栈记录尚未找到父节点的行，按行号递增处理
+     */
+    parent.resize(n);
+    std::vector<int> stack;
+    for (int i = 0; i < n; ++i)
+    {
+        while (!stack.empty() && stack.back() >= minElmIdx[i])
+        {
+            parent[stack.back()] = i;
+            stack.pop_back();
+        }
+        if (i + 1 < n && minElmIdx[i + 1] <= i)
+        {
+            parent[i] = i + 1;
+        }
+        else
+        {
+            stack.push_back(i);
+        }
+    }
+    for (int j : stack)
+    {
+        parent[j] = -1;
+    }
+}
 /* Compute the Cholesky decomposition of a CSR matrix A
  * A = L * L^T
  * Use Skyline Format to store the matrix L
  */
 void Cholesky::compute()
+{
+    std::string path;
+    if (!cacheDir.empty())
+    {
+        path = factorCachePath(cacheDir, matrixHash);
+        fromCache = loadFactor(path, matrixHash, L, cached);
+    }
+
+    if (fromCache)
+    {
+        // 直接使用映射的L，释放不再需要的内存
+        L.elements = Vec();
+        A.elements = Vec();
+    }
+    else
+    {
+        if (taskFactor)
+        {
+            computeTasks();
+        }
+        else
+        {
+            computeColumns();
+        }
+        if (!path.empty() && !saveFactor(path, matrixHash, L))
+        {
+            std::cerr << "Cholesky: failed to write factor cache " << path << std::endl;
+        }
+    }
+
+    // 缓存对角线，供求解时使用
+    const double *l = factorData();
+#pragma omp parallel for
+    for (int row = 0; row < L.rows; ++row)
+    {
+        diag_elements[row] = l[L.column_offset[row + 1] - 1];
+    }
+
+    if (singlePrecision)
+    {
+        // 转换为float后释放double的L与A，对角线仍以double缓存
+        size_t nnz = L.column_offset[L.rows];
+        Lf.resize(nnz);
+#pragma omp parallel for
+        for (size_t t = 0; t < nnz; ++t)
+        {
+            Lf[t] = (float)l[t];
+        }
+        L.elements = Vec();
+        A.elements = Vec();
+        cached = CachedFactor();
+        fromCache = false;
+        refine_r.resize(L.rows);
+        refine_d.resize(L.rows);
+    }
+    else
+    {
+        Lf = TArray<float>();
+    }
+}
+
+void Cholesky::computeColumns()
 {
     // 先计算第一列
     L.elements[0] = std::sqrt(A.elements[0]);
@@ -105,32 +314,233 @@ void Cholesky::compute()
     }
 }
 
+static inline double dotRange(const double *a, const double *b, int len)
+{
+    double sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+    for (int k = 0; k < len; ++k)
+    {
+        sum += a[k] * b[k];
+    }
+    return sum;
+}
+
+void Cholesky::factorChain(int r0, int r1)
+/* 按行计算 (up-looking), 第i行只依赖包络 [minElmIdx[i], i) 中的行
+ * L_ij = (A_ij - sum_{k < j} L_ik L_jk) / L_jj, L_ii = sqrt(A_ii - sum_{k < i} L_ik^2)
+ * 链上的行分成大小为BLOCK的块，对于块 [b0, b1):
+ * 1. 每一行中 j < b0 的部分只依赖之前的块，各行并行计算
+ * 2. 块内元素的内积中 k < b0 的部分同样可以并行计算
+ * 3. 块内剩余的小三角形串行计算
+ * 每个块只需要两次同步，而逐列计算每一列都需要一次
+ */
+{
+    const int BLOCK = 64;
+    const double *a = A.elements.data;
+    double *l = L.elements.data;
+    const size_t *offset = L.column_offset.data;
+    const int *first = minElmIdx.data;
+
+    for (int b0 = r0; b0 < r1; b0 += BLOCK)
+    {
+        int b1 = std::min(b0 + BLOCK, r1);
+
+#pragma omp taskloop grainsize(4) if (b0 - first[b1 - 1] > BLOCK)
+        for (int i = b0; i < b1; ++i)
+        {
+            double *li = l + offset[i] - first[i];
+            for (int j = first[i]; j < b0; ++j)
+            {
+                const double *lj = l + offset[j] - first[j];
+                int k0 = std::max(first[i], first[j]);
+                li[j] = (a[offset[i] + j - first[i]] - dotRange(li + k0, lj + k0, j - k0)) / lj[j];
+            }
+        }
+
+#pragma omp taskloop grainsize(4) if (b0 - first[b1 - 1] > BLOCK)
+        for (int i = b0; i < b1; ++i)
+        {
+            double *li = l + offset[i] - first[i];
+            for (int j = std::max(first[i], b0); j <= i; ++j)
+            {
+                const double *lj = l + offset[j] - first[j];
+                int k0 = std::max(first[i], first[j]);
+                li[j] = a[offset[i] + j - first[i]] - dotRange(li + k0, lj + k0, b0 - k0);
+            }
+        }
+
+        for (int i = b0; i < b1; ++i)
+        {
+            double *li = l + offset[i] - first[i];
+            int k_start = std::max(first[i], b0);
+            for (int j = k_start; j < i; ++j)
+            {
+                const double *lj = l + offset[j] - first[j];
+                int k0 = std::max(k_start, first[j]);
+                li[j] = (li[j] - dotRange(li + k0, lj + k0, j - k0)) / lj[j];
+            }
+            li[i] = std::sqrt(li[i] - dotRange(li + k_start, li + k_start, i - k_start));
+        }
+    }
+}
+
+void Cholesky::computeTasks()
+/* 消去树上 parent[j] == j + 1 的连续行构成一条链，链的根部连接到另一条链上
+ * 不同子树中的链互不依赖，每条链作为一个任务，在其所有子链完成后开始
+ * 链内部再按块使用taskloop并行，因此RCM排序下只有一条链时仍能并行
+ */
+{
+    int n = L.rows;
+    std::vector<int> chain_start;
+    for (int i = 0; i < n; ++i)
+    {
+        if (i == 0 || parent[i - 1] != i)
+        {
+            chain_start.push_back(i);
+        }
+    }
+    int nchains = chain_start.size();
+    chain_start.push_back(n);
+
+    std::vector<int> chain_parent(nchains, -1);
+    std::vector<int> pending(nchains, 0); // 尚未完成的子链个数
+    for (int c = 0; c < nchains; ++c)
+    {
+        int p = parent[chain_start[c + 1] - 1];
+        if (p >= 0)
+        {
+            int pc = std::upper_bound(chain_start.begin(), chain_start.end(), p) - chain_start.begin() - 1;
+            chain_parent[c] = pc;
+            pending[pc] += 1;
+        }
+    }
+
+    // 完成一条链后，若父链的子链均已完成，则为父链创建任务
+    auto run = [&](int c, auto &self) -> void
+    {
+        factorChain(chain_start[c], chain_start[c + 1]);
+        int pc = chain_parent[c];
+        if (pc >= 0)
+        {
+            // seq_cst使其他子链对L的写入在最后一个完成者创建父链任务之前可见
+            int remaining;
+#pragma omp atomic capture seq_cst
+            remaining = --pending[pc];
+            if (remaining == 0)
+            {
+#pragma omp task firstprivate(pc)
+                self(pc, self);
+            }
+        }
+    };
+
+    // 先记录叶子链，创建任务之后pending会被其他线程修改
+    std::vector<int> leaves;
+    for (int c = 0; c < nchains; ++c)
+    {
+        if (pending[c] == 0)
+        {
+            leaves.push_back(c);
+        }
+    }
+
+#pragma omp parallel
+#pragma omp single
+    {
+        for (int c : leaves)
+        {
+#pragma omp task firstprivate(c)
+            run(c, run);
+        }
+    }
+}
+
 void Cholesky::solve(Vec &b, Vec &x)
+/* 混合精度时进行迭代改进:
+ * r = b - (A + epsilon * I) x, 求解 L L^T d = r, x = x + d
+ * 每次改进使x的误差缩小约 cond(A) * 1e-7 倍
+ */
+{
+    solveFactor(b, x);
+    refineIter = 0;
+    if (!singlePrecision || !refMatrix)
+    {
+        return;
+    }
+
+    double b_norm = b.norm();
+    while (refineIter < maxRefine)
+    {
+        refMatrix->MVP(x, refine_r);
+        int n = L.rows;
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i)
+        {
+            refine_r[i] = b[i] - refine_r[i] - refEpsilon * x[i];
+        }
+        if (refine_r.norm() <= refineTol * b_norm)
+        {
+            break;
+        }
+        solveFactor(refine_r, refine_d);
+        x += refine_d;
+        ++refineIter;
+    }
+}
+
+void Cholesky::solveFactor(Vec &b, Vec &x)
+{
+    if (perm.size == 0)
+    {
+        solvePermuted(b, x);
+        return;
+    }
+
+    int n = L.rows;
+    for (int i = 0; i < n; ++i)
+    {
+        pb[i] = b[perm[i]];
+    }
+    solvePermuted(pb, px);
+    for (int i = 0; i < n; ++i)
+    {
+        x[perm[i]] = px[i];
+    }
+}
+
+void Cholesky::solvePermuted(Vec &b, Vec &x)
+{
+    bool parallel = parallelSolve && omp_get_max_threads() > 1;
+    if (singlePrecision)
+    {
+        parallel ? solveParallel(Lf.data, b, x) : solveSerial(Lf.data, b, x);
+    }
+    else
+    {
+        parallel ? solveParallel(factorData(), b, x) : solveSerial(factorData(), b, x);
+    }
+}
+
+template <typename T>
+void Cholesky::solveSerial(const T *l, Vec &b, Vec &x)
+// l为double或float存储的L，计算均使用double
 {
     int n = L.rows;
-    Vec y(n);
 
-    // Timer t;
-    // t.start();
     // Solve L y = b
-    Vec diag_elements(n); // cache the diag elements for backforward
     for (int row = 0; row < n; ++row)
     {
-        double diag = L.elements[L.column_offset[row + 1] - 1];
-        diag_elements[row] = diag;
         double sum = 0.0;
         int row_start = L.column_offset[row];
         int len = L.column_offset[row + 1] - row_start;
         int row_start_idx = row - len + 1;
         for (int i = 0; i < len - 1; ++i)
         {
-            sum += y[row_start_idx + i] * L.elements[row_start + i];
+            sum += y[row_start_idx + i] * l[row_start + i];
         }
-        y[row] = (b[row] - sum) / diag;
+        y[row] = (b[row] - sum) / diag_elements[row];
     }
-    // t.stop("第一部分"); // 19ms
 
-    // t.start();
     // 利用L直接求解L^T x = y
     // 将公式写出可以发现
     // x_{k+1} = (y_k+1 - L_{k+1,n-1} * x_{n-1} - L_{k+1,n-2} * x_{n-2} - ... - L_{k+1,k+2} * x_{k+2})                       / L_{k+1,k+1}
@@ -150,10 +560,106 @@ void Cholesky::solve(Vec &b, Vec &x)
         int row_start_idx = row - len + 1;
         for (int i = 0; i < len - 1; ++i)
         {
-            x[row_start_idx + i] -= L.elements[row_start + i] * x[row];
+            x[row_start_idx + i] -= l[row_start + i] * x[row];
         }
         x[row - 1] /= diag_elements[row - 1];
     }
+}
+
+template <typename T>
+void Cholesky::solveParallel(const T *l, Vec &b, Vec &x)
+/* 分块的前代与回代，行按顺序分成大小为BLOCK的块
+ * 前代: 块内每一行与之前各块的内积互不依赖，并行计算；块内的下三角部分串行求解
+ * 回代: 块内的上三角部分串行求解后，块中各行对之前各列的贡献按列分段，由各线程分别更新，不需要原子操作
+ * 包络宽度远大于块大小时，绝大部分计算都可以并行
+ */
+{
+    const int BLOCK = 128;
+    int n = L.rows;
+    int nblocks = (n + BLOCK - 1) / BLOCK;
 
-    // t.stop("第二部分"); // 800ms
-}
\ No newline at end of file
+#pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+
+        // Solve L y = b
+        for (int blk = 0; blk < nblocks; ++blk)
+        {
+            int r0 = blk * BLOCK;
+            int r1 = std::min(r0 + BLOCK, n);
+
+#pragma omp for schedule(static)
+            for (int row = r0; row < r1; ++row)
+            {
+                int row_start = L.column_offset[row];
+                int first = minElmIdx[row];
+                double sum = 0.0;
+                for (int j = first; j < r0; ++j)
+                {
+                    sum += y[j] * l[row_start + j - first];
+                }
+                y[row] = b[row] - sum;
+            }
+
+#pragma omp single
+            for (int row = r0; row < r1; ++row)
+            {
+                int row_start = L.column_offset[row];
+                int first = minElmIdx[row];
+                double sum = 0.0;
+                for (int j = std::max(first, r0); j < row; ++j)
+                {
+                    sum += y[j] * l[row_start + j - first];
+                }
+                y[row] = (y[row] - sum) / diag_elements[row];
+            }
+        }
+
+#pragma omp for schedule(static)
+        for (int row = 0; row < n; ++row)
+        {
+            x[row] = y[row];
+        }
+
+        // Solve L^T x = y
+        for (int blk = nblocks - 1; blk >= 0; --blk)
+        {
+            int r0 = blk * BLOCK;
+            int r1 = std::min(r0 + BLOCK, n);
+
+#pragma omp single
+            for (int row = r1 - 1; row >= r0; --row)
+            {
+                x[row] /= diag_elements[row];
+                int row_start = L.column_offset[row];
+                int first = minElmIdx[row];
+                for (int j = std::max(first, r0); j < row; ++j)
+                {
+                    x[j] -= l[row_start + j - first] * x[row];
+                }
+            }
+
+            // 块中各行对第 [col_min, r0) 列的贡献，每个线程负责其中一段
+            int col_min = r0;
+            for (int row = r0; row < r1; ++row)
+            {
+                col_min = std::min(col_min, minElmIdx[row]);
+            }
+            int chunk = (r0 - col_min + nthreads - 1) / nthreads;
+            int c0 = col_min + tid * chunk;
+            int c1 = std::min(c0 + chunk, r0);
+            for (int row = r0; row < r1; ++row)
+            {
+                int row_start = L.column_offset[row];
+                int first = minElmIdx[row];
+                double xr = x[row];
+                for (int j = std::max(first, c0); j < c1; ++j)
+                {
+                    x[j] -= l[row_start + j - first] * xr;
+                }
+            }
+#pragma omp barrier
+        }
+    }
+}
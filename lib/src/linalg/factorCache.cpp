@@ -0,0 +1,176 @@
+#include <factorCache.h>
+#include <CSRMatrix.h>
+#include <SKRMatrix.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char MAGIC[8] = {'F', 'E', 'M', 'C', 'H', 'O', 'L', '\0'};
+static const uint32_t VERSION = 1;
+
+struct FactorHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t value_size; // sizeof(double)
+    uint64_t hash;
+    uint64_t n;
+    uint64_t nnz;
+};
+
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+static inline uint64_t fnv(uint64_t h, const void *data, size_t bytes)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static inline uint64_t fnvWords(uint64_t h, const void *data, size_t bytes)
+// 以8字节为单位进行FNV-1a，速度比逐字节快得多，剩余不足8字节的部分逐字节处理
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    size_t words = bytes / 8;
+    for (size_t i = 0; i < words; ++i)
+    {
+        uint64_t w;
+        std::memcpy(&w, p + 8 * i, 8);
+        h ^= w;
+        h *= FNV_PRIME;
+    }
+    return fnv(h, p + 8 * words, bytes - 8 * words);
+}
+
+uint64_t hashMatrix(const CSRMatrix &A, uint64_t seed)
+{
+    uint64_t h = seed;
+    uint64_t dims[3] = {(uint64_t)A.rows, (uint64_t)A.cols, (uint64_t)A.elements.size};
+    h = fnv(h, dims, sizeof(dims));
+    h = fnvWords(h, A.row_offset.data, A.row_offset.size * sizeof(A.row_offset[0]));
+    h = fnvWords(h, A.elm_idx.data, A.elm_idx.size * sizeof(A.elm_idx[0]));
+    h = fnvWords(h, A.elements.data, A.elements.size * sizeof(double));
+    return h;
+}
+
+uint64_t hashCombine(uint64_t h, double value)
+{
+    return fnv(h, &value, sizeof(value));
+}
+
+MappedFile::MappedFile(const std::string &path) : ptr(nullptr), length(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            ptr = static_cast<const char *>(p);
+            length = st.st_size;
+        }
+    }
+    close(fd); // 映射建立后即可关闭文件
+}
+
+MappedFile::~MappedFile()
+{
+    if (ptr)
+    {
+        munmap(const_cast<char *>(ptr), length);
+    }
+}
+
+std::string factorCachePath(const std::string &dir, uint64_t hash)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "cholesky_%016llx.bin", (unsigned long long)hash);
+    return dir + "/" + name;
+}
+
+bool loadFactor(const std::string &path, uint64_t hash, const SKRMatrix &L, CachedFactor &factor)
+{
+    auto file = std::make_shared<MappedFile>(path);
+    if (!file->data() || file->size() < sizeof(FactorHeader))
+    {
+        return false;
+    }
+
+    FactorHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    size_t n = L.rows;
+    size_t nnz = L.column_offset[n];
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.value_size != sizeof(double) || header.hash != hash || header.n != n || header.nnz != nnz)
+    {
+        return false;
+    }
+    size_t expected = sizeof(FactorHeader) + (n + 1) * sizeof(uint64_t) + nnz * sizeof(double);
+    if (file->size() != expected)
+    {
+        return false;
+    }
+
+    // 哈希相同但结构不同的可能性极小，仍然检查一遍skyline结构
+    const uint64_t *offset = reinterpret_cast<const uint64_t *>(file->data() + sizeof(FactorHeader));
+    if (std::memcmp(offset, L.column_offset.data, (n + 1) * sizeof(uint64_t)) != 0)
+    {
+        return false;
+    }
+
+    factor.file = file;
+    factor.n = n;
+    factor.nnz = nnz;
+    factor.column_offset = offset;
+    factor.elements = reinterpret_cast<const double *>(offset + n + 1);
+    return true;
+}
+
+bool saveFactor(const std::string &path, uint64_t hash, const SKRMatrix &L)
+{
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos)
+    {
+        mkdir(path.substr(0, slash).c_str(), 0755); // 目录已存在时失败，忽略
+    }
+
+    std::string tmp = path + ".tmp." + std::to_string(getpid());
+    FILE *fp = std::fopen(tmp.c_str(), "wb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    FactorHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.value_size = sizeof(double);
+    header.hash = hash;
+    header.n = L.rows;
+    header.nnz = L.elements.size;
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && std::fwrite(L.column_offset.data, sizeof(uint64_t), L.column_offset.size, fp) == L.column_offset.size;
+    ok = ok && std::fwrite(L.elements.data, sizeof(double), L.elements.size, fp) == L.elements.size;
+    ok = (std::fclose(fp) == 0) && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -7,6 +7,9 @@
 #include <Mesh.h>
 #include <vector>
 #include <diagMatrix.h>
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
 
 static void massLoc(const Vec3 &AB, const Vec3 &AC, double *Mloc);  // 根据输入两个向量代表的三角形计算局部质量矩阵
 static void stiffLoc(const Vec3 &AB, const Vec3 &AC, double *Sloc); // 同上，计算刚度矩阵
@@ -21,8 +24,8 @@ void buildMassMatrix(FEMatrix &M)
  */
 {
     Mesh &mesh = M.m;
-    // 根据每个三角形进行计算
-    for (size_t t = 0; t < mesh.triangle_count(); ++t)
+    // 根据每个三角形进行计算，同一颜色的三角形没有公共顶点，可以并行累加diag
+    mesh.forEachTriangleColored([&](uint32_t t)
     {
         uint32_t a = mesh.indices[3 * t + 0];
         uint32_t b = mesh.indices[3 * t + 1];
@@ -44,7 +47,7 @@ void buildMassMatrix(FEMatrix &M)
         M.diag[c] += Mloc[0];
 
         M.offdiag[t] = Mloc[1];
-    }
+    });
 }
 
 static void massLoc(const Vec3 &AB, const Vec3 &AC, double *Mloc)
@@ -64,7 +67,7 @@ void buildStiffnessMatrix(FEMatrix &S)
  */
 {
     Mesh &mesh = S.m;
-    for (size_t t = 0; t < mesh.triangle_count(); ++t)
+    mesh.forEachTriangleColored([&](uint32_t t)
     {
         uint32_t a = mesh.indices[3 * t + 0];
         uint32_t b = mesh.indices[3 * t + 1];
@@ -85,10 +88,12 @@ void buildStiffnessMatrix(FEMatrix &S)
         S.diag[b] += Sloc[1];
         S.diag[c] += Sloc[2];
 
-        S.offdiag[3 * t + 0] = Sloc[3];
-        S.offdiag[3 * t + 1] = Sloc[4];
-        S.offdiag[3 * t + 2] = Sloc[5];
-    }
+        // 按SoA存储，见FEMatrix.h
+        size_t ntri = mesh.triangle_count();
+        S.offdiag[t] = Sloc[3];
+        S.offdiag[ntri + t] = Sloc[4];
+        S.offdiag[2 * ntri + t] = Sloc[5];
+    });
 }
 
 static void stiffLoc(const Vec3 &AB, const Vec3 &AC, double *Sloc)
@@ -122,166 +127,145 @@ void addMassToStiffness(FEMatrix &S, FEMatrix &M)
     {
         S.diag[i] += M.diag[i];
     }
-    for (size_t i = 0; i < mesh.triangle_count(); ++i)
+    size_t ntri = mesh.triangle_count();
+    for (size_t i = 0; i < ntri; ++i)
     {
-        S.offdiag[3 * i + 0] += M.offdiag[i];
-        S.offdiag[3 * i + 1] += M.offdiag[i];
-        S.offdiag[3 * i + 2] += M.offdiag[i];
+        S.offdiag[i] += M.offdiag[i];
+        S.offdiag[ntri + i] += M.offdiag[i];
+        S.offdiag[2 * ntri + i] += M.offdiag[i];
     }
 }
 
 /*-------------------使用CSR矩阵建立质量和刚度矩阵-------------------*/
-// 获取局部质量矩阵的值
-double get_Mloc_value(int i, int j, const double Mloc[2])
-{
-    if (i == j)
-        return Mloc[0]; // 对角线元素
-    else
-        return Mloc[1]; // 非对角线元素
-}
-
-// 构建顶点到局部索引的映射函数
-std::unordered_map<uint32_t, int> build_vertex_to_local_index(uint32_t a, uint32_t b, uint32_t c)
+void buildAssemblyPlan(const CSRPattern &P, const Mesh &mesh, TArray<uint32_t> &plan)
 {
-    return {
-        {a, 0},
-        {b, 1},
-        {c, 2}};
-}
+    size_t ntri = mesh.triangle_count();
+    plan.resize(9 * ntri);
+    bool missing = false;
 
-// 处理矩阵行的函数
-void process_mass_matrix_row(CSRMatrix &M, uint32_t current_row, int i,
-                             const std::unordered_map<uint32_t, int> &vertex_to_local_index,
-                             const double Mloc[2])
-{
-    size_t offset = M.row_offset[current_row];
-    size_t len = M.row_offset[current_row + 1] - offset;
-
-    for (size_t idx = 0; idx < len; ++idx)
+#pragma omp parallel for reduction(|| : missing)
+    for (size_t t = 0; t < ntri; ++t)
     {
-        uint32_t col = M.elm_idx[offset + idx];
-
-        // 检查列是否在当前三角形的顶点中
-        auto it = vertex_to_local_index.find(col);
-        if (it != vertex_to_local_index.end())
+        const uint32_t *tri = mesh.indices.data + 3 * t;
+        for (int i = 0; i < 3; ++i)
         {
-            int j = it->second;
-            double value = get_Mloc_value(i, j, Mloc);
-
-#pragma omp atomic
-            M.elements[offset + idx] += value;
+            const uint32_t *first = P.elm_idx.data + P.row_offset[tri[i]];
+            const uint32_t *last = P.elm_idx.data + P.row_offset[tri[i] + 1];
+            for (int j = 0; j < 3; ++j)
+            {
+                const uint32_t *it = std::lower_bound(first, last, tri[j]);
+                missing = missing || it == last || *it != tri[j];
+                plan[9 * t + 3 * i + j] = it - P.elm_idx.data;
+            }
         }
     }
-}
 
-void buildMassMatrix(CSRMatrix &M, Mesh &mesh)
-{
-#pragma omp parallel for
-    for (size_t t = 0; t < mesh.triangle_count(); ++t)
+    if (missing)
     {
-        uint32_t a = mesh.indices[3 * t + 0];
-        uint32_t b = mesh.indices[3 * t + 1];
-        uint32_t c = mesh.indices[3 * t + 2];
-
-        Vec3 A = mesh.vertices[a];
-        Vec3 B = mesh.vertices[b];
-        Vec3 C = mesh.vertices[c];
-
-        Vec3 AB = B - A;
-        Vec3 AC = C - A;
-
-        // 计算局部质量矩阵，2个唯一的元素
-        double Mloc[2];
-        massLoc(AB, AC, Mloc);
-
-        uint32_t triangle[3] = {a, b, c};
-
-        // 构建顶点到局部索引的映射
-        auto vertex_to_local_index = build_vertex_to_local_index(a, b, c);
-
-        // 遍历三角形的每一个顶点（对应全局矩阵的行）
-        for (int i = 0; i < 3; ++i)
-        {
-            uint32_t current_row = triangle[i];
-            process_mass_matrix_row(M, current_row, i, vertex_to_local_index, Mloc);
-        }
+        plan.resize(0);
+        throw std::runtime_error("buildAssemblyPlan: triangle entry missing from the CSR pattern.");
     }
 }
 
-// 获取 Sloc 的索引函数
-int get_Sloc_index(int i, int j)
-{
-    if (i == j)
-        return i; // 对角线元素 Sloc[0], Sloc[1], Sloc[2]
-    else if ((i == 0 && j == 1) || (i == 1 && j == 0))
-        return 3; // Sloc[3]
-    else if ((i == 0 && j == 2) || (i == 2 && j == 0))
-        return 4; // Sloc[4]
-    else if ((i == 1 && j == 2) || (i == 2 && j == 1))
-        return 5; // Sloc[5]
-    else
-        return -1; // 不可能的情况
-}
-
-// 处理矩阵行的函数
-void process_matrix_row(CSRMatrix &S, uint32_t current_row, int i, const uint32_t triangle[3],
-                        const std::unordered_map<uint32_t, int> &vertex_to_local_index, const double Sloc[6])
+template <typename LocalMatrix>
+static void assemble(CSRMatrix &A, Mesh &mesh, LocalMatrix local)
+/* 按组装计划累加每个三角形的局部矩阵 local(AB, AC, loc)，loc按行优先存储9个元素
+ * 按三角形着色并行，同一颜色的三角形不会写入相同的位置，不需要原子操作
+ * 网格无法着色时按三角形并行，用原子操作累加
+ */
 {
-    size_t offset = S.row_offset[current_row];
-    size_t len = S.row_offset[current_row + 1] - offset;
+    size_t ntri = mesh.triangle_count();
+    const uint32_t *pos = A.pattern->tri_pos.data;
+    TArray<uint32_t> plan; // 结构不是由网格建立的，没有组装计划时临时计算，不修改共享的结构
+    if (A.pattern->tri_pos.size != 9 * ntri)
+    {
+        buildAssemblyPlan(*A.pattern, mesh, plan);
+        pos = plan.data;
+    }
+    double *val = A.elements.data;
 
-    for (size_t idx = 0; idx < len; ++idx)
+    auto localAt = [&](size_t t, double *loc)
     {
-        uint32_t col = S.elm_idx[offset + idx];
+        Vec3 P0 = mesh.vertices[mesh.indices[3 * t + 0]];
+        Vec3 AB = mesh.vertices[mesh.indices[3 * t + 1]] - P0;
+        Vec3 AC = mesh.vertices[mesh.indices[3 * t + 2]] - P0;
+        local(AB, AC, loc);
+    };
 
-        // 检查列是否在当前三角形的顶点中
-        auto it = vertex_to_local_index.find(col);
-        if (it != vertex_to_local_index.end())
+    if (omp_get_max_threads() > 1 && !mesh.ensureColoring())
+    {
+#pragma omp parallel for
+        for (size_t t = 0; t < ntri; ++t)
         {
-            int j = it->second;
-            int Sloc_index = get_Sloc_index(i, j);
-
-            if (Sloc_index != -1)
+            double loc[9];
+            localAt(t, loc);
+            for (int k = 0; k < 9; ++k)
             {
 #pragma omp atomic
-                S.elements[offset + idx] += Sloc[Sloc_index];
+                val[pos[9 * t + k]] += loc[k];
             }
         }
+        return;
     }
-}
 
-void buildStiffnessMatrix(CSRMatrix &S, Mesh &mesh)
-{
-#pragma omp parallel for
-    for (size_t t = 0; t < mesh.triangle_count(); ++t)
+    mesh.forEachTriangleColored([&](uint32_t t)
     {
-        uint32_t a = mesh.indices[3 * t + 0];
-        uint32_t b = mesh.indices[3 * t + 1];
-        uint32_t c = mesh.indices[3 * t + 2];
+        double loc[9];
+        localAt(t, loc);
+        for (int k = 0; k < 9; ++k)
+        {
+            val[pos[9 * t + k]] += loc[k];
+        }
+    });
+}
 
-        Vec3 A = mesh.vertices[a];
-        Vec3 B = mesh.vertices[b];
-        Vec3 C = mesh.vertices[c];
+// Sloc中的6个值在3x3局部矩阵中的位置
+static const int stiffIndex[9] = {0, 3, 4,
+                                  3, 1, 5,
+                                  4, 5, 2};
 
-        Vec3 AB = B - A;
-        Vec3 AC = C - A;
+static void massLoc9(const Vec3 &AB, const Vec3 &AC, double *loc)
+{
+    double Mloc[2];
+    massLoc(AB, AC, Mloc);
+    for (int k = 0; k < 9; ++k)
+    {
+        loc[k] = (k % 4 == 0) ? Mloc[0] : Mloc[1]; // k = 0, 4, 8 为对角线
+    }
+}
 
-        // 计算局部刚度矩阵，6个唯一的元素
-        double Sloc[6];
-        stiffLoc(AB, AC, Sloc);
+static void stiffLoc9(const Vec3 &AB, const Vec3 &AC, double *loc)
+{
+    double Sloc[6];
+    stiffLoc(AB, AC, Sloc);
+    for (int k = 0; k < 9; ++k)
+    {
+        loc[k] = Sloc[stiffIndex[k]];
+    }
+}
 
-        uint32_t triangle[3] = {a, b, c};
+void buildMassMatrix(CSRMatrix &M, Mesh &mesh)
+{
+    assemble(M, mesh, massLoc9);
+}
 
-        // 构建顶点到局部索引的映射
-        auto vertex_to_local_index = build_vertex_to_local_index(a, b, c);
+void buildStiffnessMatrix(CSRMatrix &S, Mesh &mesh)
+{
+    assemble(S, mesh, stiffLoc9);
+}
 
-        // 遍历三角形的每一个顶点（对应全局矩阵的行）
-        for (int i = 0; i < 3; ++i)
+void buildWeightedMatrix(CSRMatrix &A, Mesh &mesh, double alpha, double beta)
+{
+    assemble(A, mesh, [alpha, beta](const Vec3 &AB, const Vec3 &AC, double *loc)
+    {
+        double Mloc[9], Sloc[9];
+        massLoc9(AB, AC, Mloc);
+        stiffLoc9(AB, AC, Sloc);
+        for (int k = 0; k < 9; ++k)
         {
-            uint32_t current_row = triangle[i];
-            process_matrix_row(S, current_row, i, triangle, vertex_to_local_index, Sloc);
+            loc[k] = alpha * Mloc[k] + beta * Sloc[k];
         }
-    }
+    });
 }
 
 void addMassToStiffness(CSRMatrix &S, CSRMatrix &M)
@@ -0,0 +1,342 @@
+#include <incompleteCholesky.h>
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <omp.h>
+
+static void buildLevelSchedule(const TArray<int> &row_level, int nlevels, TArray<int> &level_offset, TArray<int> &level_rows)
+// 根据每一行所在的层数，按层将行排列，计数后填充
+{
+    int n = row_level.size;
+    level_offset.resize(nlevels + 1);
+    level_offset.setAll(0);
+    for (int i = 0; i < n; ++i)
+    {
+        level_offset[row_level[i] + 1] += 1;
+    }
+    for (int l = 0; l < nlevels; ++l)
+    {
+        level_offset[l + 1] += level_offset[l];
+    }
+
+    level_rows.resize(n);
+    TArray<int> next(nlevels);
+    for (int l = 0; l < nlevels; ++l)
+    {
+        next[l] = level_offset[l];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        level_rows[next[row_level[i]]++] = i;
+    }
+}
+
+IncompleteCholesky::IncompleteCholesky(const CSRMatrix &A, int level, double shift)
+    : n(A.rows), level(level), shift(shift), y(A.rows)
+{
+    analyze(A);
+    compute(A);
+}
+
+void IncompleteCholesky::analyze(const CSRMatrix &A)
+/* 符号分解
+ * 逐行处理，第i行先放入A中下三角部分的元素(层数为0)
+ * 然后按列下标从小到大处理第i行的元素 j，对于已经完成的第k行 (j < k < i) 中的 L_kj，
+ * 产生填充 (i, k)，层数为 lev_ij + lev_kj + 1，超过level的填充被舍弃
+ * 第i行的元素用一个按列下标排序的链表存储，便于在当前位置之后插入
+ */
+{
+    n = A.rows;
+    const uint32_t END = (uint32_t)(-1);
+
+    std::vector<std::vector<std::pair<uint32_t, int>>> col_list(n); // col_list[j]: 已完成的行中 L_kj 的 (k, lev_kj)
+    std::vector<uint32_t> next(n, END);                            // 链表
+    std::vector<int> lev(n, 0);
+    std::vector<size_t> apos(n);
+
+    std::vector<size_t> row_offset(n + 1, 0);
+    std::vector<uint32_t> cols;
+    std::vector<size_t> a_pos;
+    cols.reserve(A.elements.size);
+    a_pos.reserve(A.elements.size);
+
+    for (int i = 0; i < n; ++i)
+    {
+        // 初始化链表为A第i行的下三角部分
+        uint32_t head = END;
+        uint32_t tail = END;
+        bool has_diag = false;
+        for (size_t t = A.row_offset[i]; t < A.row_offset[i + 1] && A.elm_idx[t] <= (size_t)i; ++t)
+        {
+            uint32_t j = A.elm_idx[t];
+            lev[j] = 0;
+            apos[j] = t;
+            next[j] = END;
+            if (head == END)
+            {
+                head = j;
+            }
+            else
+            {
+                next[tail] = j;
+            }
+            tail = j;
+            has_diag = has_diag || (j == (uint32_t)i);
+        }
+        if (!has_diag)
+        {
+            throw std::invalid_argument("IncompleteCholesky: missing diagonal element.");
+        }
+
+        if (level > 0)
+        {
+            for (uint32_t j = head; j != (uint32_t)i; j = next[j])
+            {
+                for (const auto &kl : col_list[j])
+                {
+                    uint32_t k = kl.first;
+                    int new_lev = lev[j] + kl.second + 1;
+                    if (new_lev > level)
+                    {
+                        continue;
+                    }
+
+                    // 从j开始向后寻找k的位置, k > j 因此一定在j之后
+                    uint32_t prev = j;
+                    while (next[prev] < k)
+                    {
+                        prev = next[prev];
+                    }
+                    if (next[prev] == k)
+                    {
+                        lev[k] = std::min(lev[k], new_lev);
+                    }
+                    else
+                    {
+                        next[k] = next[prev];
+                        next[prev] = k;
+                        lev[k] = new_lev;
+                        apos[k] = (size_t)(-1);
+                    }
+                }
+            }
+        }
+
+        // 写入第i行
+        for (uint32_t j = head; j != END; j = next[j])
+        {
+            cols.push_back(j);
+            a_pos.push_back(apos[j]);
+            if (level > 0 && j != (uint32_t)i)
+            {
+                col_list[j].push_back({(uint32_t)i, lev[j]});
+            }
+        }
+        row_offset[i + 1] = cols.size();
+    }
+
+    size_t nnz = cols.size();
+    L_row_offset.resize(n + 1);
+    L_col.resize(nnz);
+    A_pos.resize(nnz);
+    L_val.resize(nnz);
+    std::copy(row_offset.begin(), row_offset.end(), L_row_offset.begin());
+    std::copy(cols.begin(), cols.end(), L_col.begin());
+    std::copy(a_pos.begin(), a_pos.end(), A_pos.begin());
+
+    // 构建 U = L^T 的结构
+    U_row_offset.resize(n + 1);
+    U_row_offset.setAll(0);
+    for (size_t t = 0; t < nnz; ++t)
+    {
+        U_row_offset[L_col[t] + 1] += 1;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        U_row_offset[i + 1] += U_row_offset[i];
+    }
+    U_col.resize(nnz);
+    U_pos.resize(nnz);
+    U_val.resize(nnz);
+    std::vector<size_t> fill(U_row_offset.begin(), U_row_offset.end() - 1);
+    for (int i = 0; i < n; ++i) // 按行遍历L，保证U的每一行列下标递增，对角线在最前
+    {
+        for (size_t t = L_row_offset[i]; t < L_row_offset[i + 1]; ++t)
+        {
+            size_t dst = fill[L_col[t]]++;
+            U_col[dst] = i;
+            U_pos[dst] = t;
+        }
+    }
+
+    // 前向分层: level(i) = 1 + max{level(k) : L_ik != 0, k < i}
+    TArray<int> row_level(n);
+    int nlevels = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        int l = 0;
+        for (size_t t = L_row_offset[i]; t < L_row_offset[i + 1] - 1; ++t)
+        {
+            l = std::max(l, row_level[L_col[t]] + 1);
+        }
+        row_level[i] = l;
+        nlevels = std::max(nlevels, l + 1);
+    }
+    buildLevelSchedule(row_level, nlevels, fwd_level_offset, fwd_level_rows);
+
+    // 后向分层: level(i) = 1 + max{level(k) : U_ik != 0, k > i}
+    nlevels = 0;
+    for (int i = n - 1; i >= 0; --i)
+    {
+        int l = 0;
+        for (size_t t = U_row_offset[i] + 1; t < U_row_offset[i + 1]; ++t)
+        {
+            l = std::max(l, row_level[U_col[t]] + 1);
+        }
+        row_level[i] = l;
+        nlevels = std::max(nlevels, l + 1);
+    }
+    buildLevelSchedule(row_level, nlevels, bwd_level_offset, bwd_level_rows);
+}
+
+bool IncompleteCholesky::factorize(const CSRMatrix &A, double s)
+/* 按行计算
+ * L_ik = (a_ik - sum_{j < k} L_ij * L_kj) / L_kk, k < i
+ * L_ii = sqrt(a_ii + s - sum_{j < i} L_ij^2)
+ * 每个线程使用一个长度为n的数组记录第i行中各列元素的位置
+ */
+{
+    bool ok = true;
+    int nlevels = fwd_level_offset.size - 1;
+
+#pragma omp parallel
+    {
+        std::vector<size_t> pos(n, (size_t)(-1));
+
+        for (int l = 0; l < nlevels; ++l)
+        {
+#pragma omp for schedule(dynamic, 64)
+            for (int t = fwd_level_offset[l]; t < fwd_level_offset[l + 1]; ++t)
+            {
+                int i = fwd_level_rows[t];
+                size_t start = L_row_offset[i];
+                size_t diag = L_row_offset[i + 1] - 1;
+
+                for (size_t e = start; e <= diag; ++e)
+                {
+                    pos[L_col[e]] = e;
+                    L_val[e] = (A_pos[e] == (size_t)(-1)) ? 0.0 : A.elements[A_pos[e]];
+                }
+                L_val[diag] += s;
+
+                for (size_t e = start; e < diag; ++e)
+                {
+                    uint32_t k = L_col[e];
+                    double sum = 0.0;
+                    size_t k_diag = L_row_offset[k + 1] - 1;
+                    for (size_t f = L_row_offset[k]; f < k_diag; ++f)
+                    {
+                        size_t p = pos[L_col[f]];
+                        if (p != (size_t)(-1))
+                        {
+                            sum += L_val[p] * L_val[f];
+                        }
+                    }
+                    L_val[e] = (L_val[e] - sum) / L_val[k_diag];
+                }
+
+                double sum = 0.0;
+                for (size_t e = start; e < diag; ++e)
+                {
+                    sum += L_val[e] * L_val[e];
+                }
+                double pivot = L_val[diag] - sum;
+                if (pivot <= 0.0)
+                {
+#pragma omp atomic write
+                    ok = false;
+                    pivot = 1.0;
+                }
+                L_val[diag] = std::sqrt(pivot);
+
+                for (size_t e = start; e <= diag; ++e)
+                {
+                    pos[L_col[e]] = (size_t)(-1);
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+void IncompleteCholesky::compute(const CSRMatrix &A)
+// 主元非正时增大对角线偏移后重新分解
+{
+    double avg_diag = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        avg_diag += A(i, i);
+    }
+    avg_diag /= n;
+
+    int attempt = 0;
+    while (!factorize(A, shift))
+    {
+        if (++attempt > 30)
+        {
+            throw std::runtime_error("IncompleteCholesky: factorization broke down.");
+        }
+        shift = (shift > 0.0) ? 2.0 * shift : 1e-3 * avg_diag;
+    }
+
+#pragma omp parallel for
+    for (size_t t = 0; t < U_val.size; ++t)
+    {
+        U_val[t] = L_val[U_pos[t]];
+    }
+}
+
+void IncompleteCholesky::apply(const Vec &r, Vec &z) const
+// 依次求解 L y = r, L^T z = y
+{
+    int fwd_nlevels = fwd_level_offset.size - 1;
+    int bwd_nlevels = bwd_level_offset.size - 1;
+
+#pragma omp parallel
+    {
+        for (int l = 0; l < fwd_nlevels; ++l)
+        {
+#pragma omp for schedule(static)
+            for (int t = fwd_level_offset[l]; t < fwd_level_offset[l + 1]; ++t)
+            {
+                int i = fwd_level_rows[t];
+                size_t diag = L_row_offset[i + 1] - 1;
+                double sum = 0.0;
+                for (size_t e = L_row_offset[i]; e < diag; ++e)
+                {
+                    sum += L_val[e] * y[L_col[e]];
+                }
+                y[i] = (r[i] - sum) / L_val[diag];
+            }
+        }
+
+        for (int l = 0; l < bwd_nlevels; ++l)
+        {
+#pragma omp for schedule(static)
+            for (int t = bwd_level_offset[l]; t < bwd_level_offset[l + 1]; ++t)
+            {
+                int i = bwd_level_rows[t];
+                size_t diag = U_row_offset[i];
+                double sum = 0.0;
+                for (size_t e = diag + 1; e < U_row_offset[i + 1]; ++e)
+                {
+                    sum += U_val[e] * z[U_col[e]];
+                }
+                z[i] = (y[i] - sum) / U_val[diag];
+            }
+        }
+    }
+}
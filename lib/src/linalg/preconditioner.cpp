@@ -0,0 +1,133 @@
+#include <preconditioner.h>
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <diagMatrix.h>
+#include <fem.h>
+#include <cmath>
+#include <stdexcept>
+
+/*-------------------Jacobi-------------------*/
+JacobiPreconditioner::JacobiPreconditioner(const CSRMatrix &A)
+    : D(A.rows)
+{
+    update(A);
+}
+
+void JacobiPreconditioner::update(const CSRMatrix &A)
+{
+    buildDiagMatrix(A, D);
+}
+
+void JacobiPreconditioner::apply(const Vec &r, Vec &z) const
+{
+    int n = D.rows;
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        z[i] = r[i] / D.diag[i];
+    }
+}
+
+/*-------------------SSOR-------------------*/
+SSORPreconditioner::SSORPreconditioner(const CSRMatrix &A, double omega)
+    : A(A), omega(omega), diag_idx(A.rows), y(A.rows)
+{
+    if (omega <= 0.0 || omega >= 2.0)
+    {
+        throw std::invalid_argument("SSOR: omega must lie in (0, 2).");
+    }
+
+    for (int row = 0; row < A.rows; ++row)
+    {
+        size_t i = A.row_offset[row];
+        while (i < A.row_offset[row + 1] && A.elm_idx[i] != (size_t)row)
+        {
+            ++i;
+        }
+        if (i == A.row_offset[row + 1])
+        {
+            throw std::invalid_argument("SSOR: missing diagonal element.");
+        }
+        diag_idx[row] = i;
+    }
+}
+
+void SSORPreconditioner::apply(const Vec &r, Vec &z) const
+/* 求解 (D + wL) D^{-1} (D + wU) z = w(2 - w) r
+ * 前向: (D + wL) y = w(2 - w) r
+ * 后向: (D + wU) z = D y
+ * 每一行的元素按列下标排序，因此对角线之前为L部分，之后为U部分
+ */
+{
+    int n = A.rows;
+    double scale = omega * (2.0 - omega);
+
+    for (int row = 0; row < n; ++row)
+    {
+        double sum = 0.0;
+        for (size_t i = A.row_offset[row]; i < diag_idx[row]; ++i)
+        {
+            sum += A.elements[i] * y[A.elm_idx[i]];
+        }
+        y[row] = (scale * r[row] - omega * sum) / A.elements[diag_idx[row]];
+    }
+
+    for (int row = n - 1; row >= 0; --row)
+    {
+        double sum = 0.0;
+        for (size_t i = diag_idx[row] + 1; i < A.row_offset[row + 1]; ++i)
+        {
+            sum += A.elements[i] * z[A.elm_idx[i]];
+        }
+        double d = A.elements[diag_idx[row]];
+        z[row] = (d * y[row] - omega * sum) / d;
+    }
+}
+
+/*-------------------Polynomial-------------------*/
+PolynomialPreconditioner::PolynomialPreconditioner(const CSRMatrix &A, int degree)
+    : A(A), degree(degree), theta(1.0), D(A.rows), Az(A.rows)
+{
+    update();
+}
+
+void PolynomialPreconditioner::update()
+// theta = 1 / max_i (sum_j |a_ij| / a_ii)
+{
+    buildDiagMatrix(A, D);
+
+    double lambda_max = 0.0;
+#pragma omp parallel for reduction(max : lambda_max)
+    for (int row = 0; row < A.rows; ++row)
+    {
+        double s = 0.0;
+        for (size_t i = A.row_offset[row]; i < A.row_offset[row + 1]; ++i)
+        {
+            s += std::fabs(A.elements[i]);
+        }
+        s /= D.diag[row];
+        lambda_max = std::max(lambda_max, s);
+    }
+    theta = 1.0 / lambda_max;
+}
+
+void PolynomialPreconditioner::apply(const Vec &r, Vec &z) const
+// z_0 = theta * D^{-1} r, z_{k+1} = z_k + theta * D^{-1} (r - A z_k)
+{
+    int n = A.rows;
+#pragma omp parallel for
+    for (int i = 0; i < n; ++i)
+    {
+        z[i] = theta * r[i] / D.diag[i];
+    }
+
+    for (int k = 0; k < degree; ++k)
+    {
+        A.MVP(z, Az);
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i)
+        {
+            z[i] += theta * (r[i] - Az[i]) / D.diag[i];
+        }
+    }
+}
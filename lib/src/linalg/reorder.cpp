@@ -0,0 +1,324 @@
+#include <reorder.h>
+#include <TArray.h>
+#include <CSRMatrix.h>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+
+static int bfsLevels(const CSRMatrix &A, int root, std::vector<int> &level, std::vector<int> &order, const int *part = nullptr, int id = 0)
+/* 从root出发进行广度优先搜索，level记录每个点所在的层数(未访问为-1)
+ * order依次记录访问的点，返回层数
+ * 调用前需要保证当前连通分量中的点level均为-1
+ * part不为空时只在 part[v] == id 的点构成的子图中搜索
+ */
+{
+    order.clear();
+    order.push_back(root);
+    level[root] = 0;
+    int depth = 0;
+    for (size_t head = 0; head < order.size(); ++head)
+    {
+        int v = order[head];
+        for (size_t t = A.row_offset[v]; t < A.row_offset[v + 1]; ++t)
+        {
+            int w = A.elm_idx[t];
+            if (level[w] < 0 && (!part || part[w] == id))
+            {
+                level[w] = level[v] + 1;
+                depth = std::max(depth, level[w]);
+                order.push_back(w);
+            }
+        }
+    }
+    return depth + 1;
+}
+
+static int pseudoPeripheralNode(const CSRMatrix &A, int root, std::vector<int> &level, std::vector<int> &order, const int *part = nullptr, int id = 0)
+/* George-Liu 算法寻找伪外围点
+ * 从root出发BFS，在最后一层中选择度数最小的点重新出发，直到层数不再增加
+ * 返回时level被恢复为-1
+ */
+{
+    int depth = bfsLevels(A, root, level, order, part, id);
+    while (true)
+    {
+        int last_level = level[order.back()];
+        int candidate = order.back();
+        size_t min_degree = (size_t)(-1);
+        for (int v : order)
+        {
+            size_t degree = A.row_offset[v + 1] - A.row_offset[v];
+            if (level[v] == last_level && degree < min_degree)
+            {
+                min_degree = degree;
+                candidate = v;
+            }
+        }
+
+        for (int v : order)
+        {
+            level[v] = -1;
+        }
+        int new_depth = bfsLevels(A, candidate, level, order, part, id);
+        if (new_depth <= depth)
+        {
+            for (int v : order)
+            {
+                level[v] = -1;
+            }
+            return root;
+        }
+        depth = new_depth;
+        root = candidate;
+    }
+}
+
+void reverseCuthillMcKee(const CSRMatrix &A, TArray<int> &perm)
+{
+    int n = A.rows;
+    perm.resize(n);
+
+    std::vector<int> level(n, -1);
+    std::vector<int> order;
+    std::vector<bool> visited(n, false);
+    std::vector<std::pair<size_t, int>> neighbours;
+
+    int count = 0;
+    for (int start = 0; start < n; ++start)
+    {
+        if (visited[start])
+        {
+            continue;
+        }
+
+        int root = pseudoPeripheralNode(A, start, level, order);
+
+        // Cuthill-McKee: 广度优先，每个点的未访问邻居按度数从小到大加入
+        int head = count;
+        perm[count++] = root;
+        visited[root] = true;
+        while (head < count)
+        {
+            int v = perm[head++];
+            neighbours.clear();
+            for (size_t t = A.row_offset[v]; t < A.row_offset[v + 1]; ++t)
+            {
+                int w = A.elm_idx[t];
+                if (!visited[w])
+                {
+                    visited[w] = true;
+                    neighbours.push_back({A.row_offset[w + 1] - A.row_offset[w], w});
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            for (const auto &dw : neighbours)
+            {
+                perm[count++] = dw.second;
+            }
+        }
+    }
+
+    std::reverse(perm.begin(), perm.end());
+}
+
+static void dissect(const CSRMatrix &A, const std::vector<int> &verts, std::vector<int> &part, int &next_id,
+                    std::vector<int> &level, std::vector<int> &order, TArray<int> &perm, int lo, int leafSize);
+
+static void placeSorted(std::vector<int> &verts, TArray<int> &perm, int lo)
+{
+    std::sort(verts.begin(), verts.end());
+    std::copy(verts.begin(), verts.end(), perm.begin() + lo);
+}
+
+static void dissectComponent(const CSRMatrix &A, std::vector<int> &comp, int depth, std::vector<int> &part, int &next_id,
+                             std::vector<int> &level, std::vector<int> &order, TArray<int> &perm, int lo, int leafSize)
+/* comp为一个连通分量，level为从伪外围点出发的BFS层数
+ * 选取一层作为分隔集，两侧分别递归，结果写入perm[lo, lo + comp.size())
+ */
+{
+    int N = comp.size();
+
+    // 选取使两侧点数最接近的一层作为分隔集
+    std::vector<int> count(depth, 0);
+    for (int v : comp)
+    {
+        count[level[v]] += 1;
+    }
+    int sep = -1;
+    int best = N;
+    int left = count[0];
+    for (int m = 1; m < depth - 1 && N > leafSize; ++m)
+    {
+        int right = N - left - count[m];
+        if (std::abs(left - right) < best)
+        {
+            best = std::abs(left - right);
+            sep = m;
+        }
+        left += count[m];
+    }
+
+    if (sep < 0)
+    {
+        for (int v : comp)
+        {
+            level[v] = -1;
+        }
+        placeSorted(comp, perm, lo);
+        return;
+    }
+
+    std::vector<int> p1, p2, separator;
+    int id1 = next_id++;
+    int id2 = next_id++;
+    int id_sep = next_id++;
+    for (int v : comp)
+    {
+        if (level[v] < sep)
+        {
+            p1.push_back(v);
+            part[v] = id1;
+        }
+        else if (level[v] > sep)
+        {
+            p2.push_back(v);
+            part[v] = id2;
+        }
+        else
+        {
+            separator.push_back(v);
+            part[v] = id_sep;
+        }
+        level[v] = -1;
+    }
+    comp.clear();
+    comp.shrink_to_fit();
+
+    placeSorted(separator, perm, lo + p1.size() + p2.size());
+    int lo2 = lo + p1.size();
+    dissect(A, p1, part, next_id, level, order, perm, lo, leafSize);
+    dissect(A, p2, part, next_id, level, order, perm, lo2, leafSize);
+}
+
+static void dissect(const CSRMatrix &A, const std::vector<int> &verts, std::vector<int> &part, int &next_id,
+                    std::vector<int> &level, std::vector<int> &order, TArray<int> &perm, int lo, int leafSize)
+/* 对点集verts(part均相同)进行剖分，结果写入perm[lo, lo + verts.size())
+ * 子图不连通时逐个连通分量循环处理，只对分隔集两侧递归，递归深度不随连通分量的个数增加
+ */
+{
+    if (verts.empty())
+    {
+        return;
+    }
+    int id = part[verts[0]];
+    if ((int)verts.size() <= leafSize)
+    {
+        std::vector<int> leaf(verts);
+        placeSorted(leaf, perm, lo);
+        return;
+    }
+
+    for (int v : verts)
+    {
+        if (part[v] != id) // 已经属于之前处理过的连通分量
+        {
+            continue;
+        }
+        int root = pseudoPeripheralNode(A, v, level, order, part.data(), id);
+        int depth = bfsLevels(A, root, level, order, part.data(), id);
+        std::vector<int> comp(order);
+        int comp_id = next_id++;
+        for (int u : comp)
+        {
+            part[u] = comp_id;
+        }
+        int size = comp.size();
+        dissectComponent(A, comp, depth, part, next_id, level, order, perm, lo, leafSize);
+        lo += size;
+    }
+}
+
+void nestedDissection(const CSRMatrix &A, TArray<int> &perm, int leafSize)
+{
+    int n = A.rows;
+    perm.resize(n);
+    if (n == 0)
+    {
+        return;
+    }
+
+    std::vector<int> level(n, -1);
+    std::vector<int> order;
+    std::vector<int> part(n, 0);
+    std::vector<int> verts(n);
+    for (int i = 0; i < n; ++i)
+    {
+        verts[i] = i;
+    }
+    int next_id = 1;
+    dissect(A, verts, part, next_id, level, order, perm, 0, std::max(leafSize, 1));
+}
+
+void invertPermutation(const TArray<int> &perm, TArray<int> &iperm)
+{
+    iperm.resize(perm.size);
+    for (size_t i = 0; i < perm.size; ++i)
+    {
+        iperm[perm[i]] = i;
+    }
+}
+
+void permuteMatrix(const CSRMatrix &A, const TArray<int> &perm, CSRMatrix &PA)
+{
+    int n = A.rows;
+    TArray<int> iperm;
+    invertPermutation(perm, iperm);
+
+    PA.rows = n;
+    PA.cols = n;
+    PA.row_offset.resize(n + 1);
+    PA.row_offset[0] = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        int old = perm[i];
+        PA.row_offset[i + 1] = PA.row_offset[i] + (A.row_offset[old + 1] - A.row_offset[old]);
+    }
+    PA.elm_idx.resize(A.elm_idx.size);
+    PA.elements.resize(A.elements.size);
+
+#pragma omp parallel
+    {
+        std::vector<std::pair<size_t, double>> row;
+#pragma omp for
+        for (int i = 0; i < n; ++i)
+        {
+            int old = perm[i];
+            row.clear();
+            for (size_t t = A.row_offset[old]; t < A.row_offset[old + 1]; ++t)
+            {
+                row.push_back({(size_t)iperm[A.elm_idx[t]], A.elements[t]});
+            }
+            std::sort(row.begin(), row.end());
+
+            size_t dst = PA.row_offset[i];
+            for (const auto &cv : row)
+            {
+                PA.elm_idx[dst] = cv.first;
+                PA.elements[dst] = cv.second;
+                ++dst;
+            }
+        }
+    }
+}
+
+size_t envelopeSize(const CSRMatrix &A)
+{
+    size_t s = 0;
+    for (int i = 0; i < A.rows; ++i)
+    {
+        size_t left = A.elm_idx[A.row_offset[i]];
+        s += i - std::min(left, (size_t)i) + 1;
+    }
+    return s;
+}
@@ -0,0 +1,405 @@
+#include <supernodalCholesky.h>
+#include <CSRMatrix.h>
+#include <TArray.h>
+#include <reorder.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
+
+SupernodalCholesky::SupernodalCholesky()
+    : n(0), ordering(Cholesky::NestedDissection), epsilon(0.0), PA(0), nsuper(0) {}
+
+void SupernodalCholesky::attach(CSRMatrix &A_CSR, double eps)
+{
+    attach(A_CSR);
+    epsilon = eps;
+}
+
+void SupernodalCholesky::attach(CSRMatrix &A_CSR)
+{
+    n = A_CSR.rows;
+    epsilon = 0.0;
+
+    if (ordering == Cholesky::RCM)
+    {
+        reverseCuthillMcKee(A_CSR, perm);
+    }
+    else if (ordering == Cholesky::NestedDissection)
+    {
+        nestedDissection(A_CSR, perm);
+    }
+    else
+    {
+        perm.resize(n);
+        for (int i = 0; i < n; ++i)
+        {
+            perm[i] = i;
+        }
+    }
+    permuteMatrix(A_CSR, perm, PA);
+    pb.resize(n);
+
+    // 消去树，使用路径压缩的祖先数组
+    parent.resize(n);
+    std::vector<int> ancestor(n, -1);
+    for (int i = 0; i < n; ++i)
+    {
+        parent[i] = -1;
+        for (size_t t = PA.row_offset[i]; t < PA.row_offset[i + 1] && (int)PA.elm_idx[t] < i; ++t)
+        {
+            int r = PA.elm_idx[t];
+            while (ancestor[r] != -1 && ancestor[r] != i)
+            {
+                int next = ancestor[r];
+                ancestor[r] = i;
+                r = next;
+            }
+            if (ancestor[r] == -1)
+            {
+                ancestor[r] = i;
+                parent[r] = i;
+            }
+        }
+    }
+
+    // 列计数: L的第i行的非零元为行子树上的点，即从A_ij (j < i) 沿消去树向上直到i
+    std::vector<int> count(n, 1);
+    std::vector<int> mark(n, -1);
+    for (int i = 0; i < n; ++i)
+    {
+        mark[i] = i;
+        for (size_t t = PA.row_offset[i]; t < PA.row_offset[i + 1] && (int)PA.elm_idx[t] < i; ++t)
+        {
+            for (int k = PA.elm_idx[t]; mark[k] != i; k = parent[k])
+            {
+                count[k] += 1;
+                mark[k] = i;
+            }
+        }
+    }
+
+    // 划分超节点
+    std::vector<int> starts;
+    for (int j = 0; j < n; ++j)
+    {
+        bool merge = j > 0 && parent[j - 1] == j && count[j - 1] == count[j] + 1;
+        if (!merge)
+        {
+            starts.push_back(j);
+        }
+    }
+    nsuper = starts.size();
+    super_start.resize(nsuper + 1);
+    std::copy(starts.begin(), starts.end(), super_start.begin());
+    super_start[nsuper] = n;
+
+    col_to_super.resize(n);
+    for (int s = 0; s < nsuper; ++s)
+    {
+        for (int j = super_start[s]; j < super_start[s + 1]; ++j)
+        {
+            col_to_super[j] = s;
+        }
+    }
+
+    // 超节点的行结构等于其第一列的结构，再次遍历行子树，只记录经过超节点第一列的行
+    rows_offset.resize(nsuper + 1);
+    value_offset.resize(nsuper + 1);
+    rows_offset[0] = 0;
+    value_offset[0] = 0;
+    for (int s = 0; s < nsuper; ++s)
+    {
+        size_t nrows = count[super_start[s]];
+        size_t ncols = super_start[s + 1] - super_start[s];
+        rows_offset[s + 1] = rows_offset[s] + nrows;
+        value_offset[s + 1] = value_offset[s] + nrows * ncols;
+    }
+    rows.resize(rows_offset[nsuper]);
+    std::vector<size_t> fill(nsuper);
+    for (int s = 0; s < nsuper; ++s)
+    {
+        rows[rows_offset[s]] = super_start[s];
+        fill[s] = rows_offset[s] + 1;
+    }
+    std::fill(mark.begin(), mark.end(), -1);
+    for (int i = 0; i < n; ++i)
+    {
+        mark[i] = i;
+        for (size_t t = PA.row_offset[i]; t < PA.row_offset[i + 1] && (int)PA.elm_idx[t] < i; ++t)
+        {
+            for (int k = PA.elm_idx[t]; mark[k] != i; k = parent[k])
+            {
+                int s = col_to_super[k];
+                if (super_start[s] == k)
+                {
+                    rows[fill[s]++] = i;
+                }
+                mark[k] = i;
+            }
+        }
+    }
+
+    // 更新关系: 超节点d的非对角块中，属于同一个超节点s的连续行对s产生一次更新
+    update_offset.resize(nsuper + 1);
+    update_offset.setAll(0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            for (int s = 0; s < nsuper; ++s)
+            {
+                update_offset[s + 1] += update_offset[s];
+            }
+            update_super.resize(update_offset[nsuper]);
+            update_pos.resize(update_offset[nsuper]);
+            for (int s = 0; s < nsuper; ++s)
+            {
+                fill[s] = update_offset[s];
+            }
+        }
+        for (int d = 0; d < nsuper; ++d)
+        {
+            size_t ncols = super_start[d + 1] - super_start[d];
+            int last = -1;
+            for (size_t p = rows_offset[d] + ncols; p < rows_offset[d + 1]; ++p)
+            {
+                int s = col_to_super[rows[p]];
+                if (s != last)
+                {
+                    if (pass == 0)
+                    {
+                        update_offset[s + 1] += 1;
+                    }
+                    else
+                    {
+                        update_super[fill[s]] = d;
+                        update_pos[fill[s]] = p - rows_offset[d];
+                        fill[s] += 1;
+                    }
+                    last = s;
+                }
+            }
+        }
+    }
+
+    // 超节点消去树按高度分层
+    TArray<int> height(nsuper, 0);
+    int nlevels = 0;
+    for (int s = 0; s < nsuper; ++s)
+    {
+        nlevels = std::max(nlevels, height[s] + 1);
+        int p = parent[super_start[s + 1] - 1];
+        if (p >= 0)
+        {
+            int sp = col_to_super[p];
+            height[sp] = std::max(height[sp], height[s] + 1);
+        }
+    }
+    level_offset.resize(nlevels + 1);
+    level_offset.setAll(0);
+    for (int s = 0; s < nsuper; ++s)
+    {
+        level_offset[height[s] + 1] += 1;
+    }
+    for (int l = 0; l < nlevels; ++l)
+    {
+        level_offset[l + 1] += level_offset[l];
+    }
+    level_supers.resize(nsuper);
+    std::vector<int> next(level_offset.begin(), level_offset.end() - 1);
+    for (int s = 0; s < nsuper; ++s)
+    {
+        level_supers[next[height[s]]++] = s;
+    }
+
+    values.resize(value_offset[nsuper]);
+}
+
+void SupernodalCholesky::factorSupernode(int s, int *map, Vec &work)
+{
+    int first = super_start[s];
+    int last = super_start[s + 1];
+    int ncols = last - first;
+    int nrows = rows_offset[s + 1] - rows_offset[s];
+    const int *srows = &rows[rows_offset[s]];
+    double *Ls = &values[value_offset[s]];
+
+    for (int p = 0; p < nrows; ++p)
+    {
+        map[srows[p]] = p;
+    }
+
+    // 组装A: L(j, c) = A(c, j), j >= c
+    std::fill(Ls, Ls + (size_t)nrows * ncols, 0.0);
+    for (int c = first; c < last; ++c)
+    {
+        double *col = Ls + (size_t)(c - first) * nrows;
+        for (size_t t = PA.row_offset[c + 1]; t-- > PA.row_offset[c] && (int)PA.elm_idx[t] >= c;)
+        {
+            col[map[PA.elm_idx[t]]] += PA.elements[t];
+        }
+        col[c - first] += epsilon;
+    }
+
+    // 收集后代超节点的更新: W = L_d[p0:, :] * L_d[p0:p0+k, :]^T
+    for (size_t u = update_offset[s]; u < update_offset[s + 1]; ++u)
+    {
+        int d = update_super[u];
+        int p0 = update_pos[u];
+        int d_ncols = super_start[d + 1] - super_start[d];
+        int d_nrows = rows_offset[d + 1] - rows_offset[d];
+        const int *drows = &rows[rows_offset[d]];
+        const double *Ld = &values[value_offset[d]];
+
+        int m = d_nrows - p0;
+        int k = 0;
+        while (k < m && drows[p0 + k] < last)
+        {
+            ++k;
+        }
+
+        work.resize((size_t)m * k);
+        double *W = work.data;
+        std::fill(W, W + (size_t)m * k, 0.0);
+        for (int c = 0; c < d_ncols; ++c)
+        {
+            const double *col = Ld + (size_t)c * d_nrows + p0;
+            for (int b = 0; b < k; ++b)
+            {
+                double coeff = col[b];
+                double *Wb = W + (size_t)b * m;
+#pragma omp simd
+                for (int a = b; a < m; ++a)
+                {
+                    Wb[a] += col[a] * coeff;
+                }
+            }
+        }
+
+        for (int b = 0; b < k; ++b)
+        {
+            double *col = Ls + (size_t)(drows[p0 + b] - first) * nrows;
+            const double *Wb = W + (size_t)b * m;
+            for (int a = b; a < m; ++a)
+            {
+                col[map[drows[p0 + a]]] -= Wb[a];
+            }
+        }
+    }
+
+    // 稠密面板分解，同时完成对角块的分解与非对角块的三角求解
+    for (int j = 0; j < ncols; ++j)
+    {
+        double *cj = Ls + (size_t)j * nrows;
+        for (int c = 0; c < j; ++c)
+        {
+            const double *cc = Ls + (size_t)c * nrows;
+            double coeff = cc[j];
+#pragma omp simd
+            for (int i = j; i < nrows; ++i)
+            {
+                cj[i] -= cc[i] * coeff;
+            }
+        }
+        double d = std::sqrt(cj[j]);
+        cj[j] = d;
+        double inv = 1.0 / d;
+#pragma omp simd
+        for (int i = j + 1; i < nrows; ++i)
+        {
+            cj[i] *= inv;
+        }
+    }
+}
+
+void SupernodalCholesky::compute()
+{
+    int nlevels = level_offset.size - 1;
+    bool ok = true;
+
+#pragma omp parallel
+    {
+        std::vector<int> map(n);
+        Vec work;
+
+        for (int l = 0; l < nlevels; ++l)
+        {
+#pragma omp for schedule(dynamic, 1)
+            for (int t = level_offset[l]; t < level_offset[l + 1]; ++t)
+            {
+                int s = level_supers[t];
+                factorSupernode(s, map.data(), work);
+                double *Ls = &values[value_offset[s]];
+                int nrows = rows_offset[s + 1] - rows_offset[s];
+                int ncols = super_start[s + 1] - super_start[s];
+                for (int j = 0; j < ncols; ++j)
+                {
+                    if (!(Ls[(size_t)j * nrows + j] > 0.0))
+                    {
+#pragma omp atomic write
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!ok)
+    {
+        throw std::runtime_error("SupernodalCholesky: matrix is not positive definite.");
+    }
+}
+
+void SupernodalCholesky::solve(Vec &b, Vec &x)
+// 依次求解 L y = Pb, L^T z = y, x = P^T z
+{
+    for (int i = 0; i < n; ++i)
+    {
+        pb[i] = b[perm[i]];
+    }
+
+    for (int s = 0; s < nsuper; ++s)
+    {
+        int first = super_start[s];
+        int ncols = super_start[s + 1] - first;
+        int nrows = rows_offset[s + 1] - rows_offset[s];
+        const int *srows = &rows[rows_offset[s]];
+        const double *Ls = &values[value_offset[s]];
+        for (int j = 0; j < ncols; ++j)
+        {
+            const double *cj = Ls + (size_t)j * nrows;
+            double yj = pb[first + j] / cj[j];
+            pb[first + j] = yj;
+            for (int i = j + 1; i < nrows; ++i)
+            {
+                pb[srows[i]] -= cj[i] * yj;
+            }
+        }
+    }
+
+    for (int s = nsuper - 1; s >= 0; --s)
+    {
+        int first = super_start[s];
+        int ncols = super_start[s + 1] - first;
+        int nrows = rows_offset[s + 1] - rows_offset[s];
+        const int *srows = &rows[rows_offset[s]];
+        const double *Ls = &values[value_offset[s]];
+        for (int j = ncols - 1; j >= 0; --j)
+        {
+            const double *cj = Ls + (size_t)j * nrows;
+            double sum = 0.0;
+            for (int i = j + 1; i < nrows; ++i)
+            {
+                sum += cj[i] * pb[srows[i]];
+            }
+            pb[first + j] = (pb[first + j] - sum) / cj[j];
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        x[perm[i]] = pb[i];
+    }
+}
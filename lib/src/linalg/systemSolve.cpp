@@ -128,6 +128,139 @@ bool conjugateGradientSolve(Matrix &A, Vec &B, Vec &u, Vec &r, Vec &p, Vec &Ap,
     }
 }
 
+static double cg_fused_update(Vec &u, Vec &r, Vec &p, Vec &s, const Vec &w, double alpha, double beta)
+/* 一次遍历完成
+ * p = r + beta * p, s = w + beta * s
+ * u = u + alpha * p, r = r - alpha * s
+ * 并返回更新后的 <r, r>
+ */
+{
+    double r2 = 0.0;
+    int n = r.size;
+#pragma omp parallel for reduction(+ : r2)
+    for (int i = 0; i < n; ++i)
+    {
+        double pi = r[i] + beta * p[i];
+        double si = w[i] + beta * s[i];
+        p[i] = pi;
+        s[i] = si;
+        u[i] += alpha * pi;
+        double ri = r[i] - alpha * si;
+        r[i] = ri;
+        r2 += ri * ri;
+    }
+    return r2;
+}
+
+bool pipelinedConjugateGradientSolve(Matrix &A, Vec &B, Vec &u, Vec &r, Vec &p, Vec &s, Vec &w, double *rel_error, int *iter, double tol, int iterMax)
+/* Chronopoulos-Gear CG
+ * 利用 s_k = A p_k = w_k + beta_k * s_{k-1} 的递推关系，不再单独计算 Ap
+ * 两个内积 <r, r> 与 <r, Ar> 在同一处得到，alpha 由递推公式给出
+ *
+ *          alpha_k = gamma_k / (delta_k - beta_k * gamma_k / alpha_{k-1})
+ *
+ * 其中 gamma_k = <r_k, r_k>, delta_k = <r_k, A r_k>, beta_k = gamma_k / gamma_{k-1}
+ */
+{
+    double b2 = dot(B, B);
+
+    A.MVP(u, r);
+    blas_axpby(1.0, B, -1.0, r, r);
+
+    p.setAll(0.0);
+    s.setAll(0.0);
+
+    double gamma = dot(r, r);
+    double delta = A.MVP_dot(r, w);
+    double alpha = gamma / delta;
+    double beta = 0.0;
+
+    *iter = 0;
+    *rel_error = sqrt(gamma / b2);
+
+    while (((*iter)++ < iterMax) && (*rel_error > tol))
+    {
+        double gamma_new = cg_fused_update(u, r, p, s, w, alpha, beta);
+        delta = A.MVP_dot(r, w);
+
+        beta = gamma_new / gamma;
+        alpha = gamma_new / (delta - beta * gamma_new / alpha);
+        gamma = gamma_new;
+        *rel_error = sqrt(gamma / b2);
+    }
+
+    if ((*iter) >= iterMax && *rel_error >= tol)
+    {
+        return false;
+    }
+    else
+    {
+        return true;
+    }
+}
+
+bool preconditionedConjugateGradientSolve(Matrix &A, const Preconditioner &P, Vec &B, Vec &u, Vec &r, Vec &z, Vec &p, Vec &Ap, double *rel_error, int *iter, double tol, int iterMax)
+/* 与CG相比，搜索方向由 z = P r 生成
+ * alpha_k = <r_k, z_k> / <p_k, A p_k>
+ * beta_k  = <r_{k+1}, z_{k+1}> / <r_k, z_k>
+ * p_{k+1} = z_{k+1} + beta_k * p_k
+ */
+{
+    int n = B.size;
+    double b2 = dot(B, B);
+
+    A.MVP(u, r);
+    blas_axpby(1.0, B, -1.0, r, r);
+
+    P.apply(r, z);
+    p = z;
+
+    *iter = 0;
+    double rz = dot(r, z);
+    double r2 = dot(r, r);
+    *rel_error = sqrt(r2 / b2);
+
+    while (((*iter)++ < iterMax) && (*rel_error > tol))
+    {
+        double alpha = rz / A.MVP_dot(p, Ap);
+
+        r2 = 0.0;
+#pragma omp parallel for reduction(+ : r2)
+        for (int i = 0; i < n; ++i)
+        {
+            u[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+            r2 += r[i] * r[i];
+        }
+        *rel_error = sqrt(r2 / b2);
+
+        P.apply(r, z);
+        double rz_new = 0.0;
+#pragma omp parallel for reduction(+ : rz_new)
+        for (int i = 0; i < n; ++i)
+        {
+            rz_new += r[i] * z[i];
+        }
+
+        double beta = rz_new / rz;
+        rz = rz_new;
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i)
+        {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+
+    if ((*iter) >= iterMax && *rel_error >= tol)
+    {
+        return false;
+    }
+    else
+    {
+        return true;
+    }
+}
+
 /* Since S + M is symmetric and positive definite we can solve
  * the system by the gradient descent method. This is by far
  * not the best method for ill conditionned matrices, but the point
@@ -8,7 +8,7 @@
 #include <timer.h>
 #include <cholesky.h>
 
-FEMData::FEMData(int subdiv, MeshType meshtype, double (*func)(Vec3 pos))
+FEMData::FEMData(int subdiv, MeshType meshtype, double (*func)(Vec3 pos), const std::string &cacheDir)
     : mesh(subdiv, meshtype), A(mesh), u(mesh.vertex_count(), 0.0), B(mesh.vertex_count())
 {
     Timer t;
@@ -39,7 +39,10 @@ FEMData::FEMData(int subdiv, MeshType meshtype, double (*func)(Vec3 pos))
     t.start();
     // conjugateGradientSolve(A, B, u, r, p, Ap, &rel_error, &iter, tol, iterMax);
     Cholesky chol;
+    chol.setOrdering(Cholesky::RCM);
+    chol.setCacheDir(cacheDir);
     chol.attach(A, 1e-10);
+    std::cout << "包络大小: " << chol.envelopeBefore << " -> " << chol.envelopeAfter << std::endl;
     chol.compute();
     chol.solve(B, u);
 
@@ -5,137 +5,385 @@
 #include <fem.h>
 #include <systemSolve.h>
 #include <timer.h>
+#include <algorithm>
+#include <vector>
 
-MultiGrid::MultiGrid(Mesh &mesh, void funcBuildMatrix(NSMatrix &M))
-    : mt(mesh.meshtype), subdiv(mesh.subdiv), w(0.6),
-      m0(mesh), m1(subdiv / 2, mt, true), m2(subdiv / 4, mt, true), m3(subdiv / 8, mt, true),
-      A0(m0), A1(m1), A2(m2), A3(m3),
-      D0(A0.rows),
-      r0(A0.rows, 0.0), r1(m1.vertex_count(), 0.0), r2(m2.vertex_count(), 0.0), r3(A3.rows, 0.0)
+static void buildLevels(std::vector<MultiGrid::Level> &levels, Mesh &mesh, int coarseSubdiv)
+// 逐层减半，直到不能整除或低于最粗层的大小
 {
-    tol = 1e-6;
-    // 根据传入的函数构建矩阵
-    funcBuildMatrix(A0);
-    funcBuildMatrix(A1);
-    funcBuildMatrix(A2);
-    funcBuildMatrix(A3);
+    if (!mesh.dupToNoDupIndex)
+    {
+        throw std::invalid_argument("MultiGrid: mesh must be created with saveDTND = true.");
+    }
+
+    levels.emplace_back();
+    levels.back().mesh = &mesh;
+    for (int s = mesh.subdiv; s % 2 == 0 && s / 2 >= std::max(coarseSubdiv, 1); s /= 2)
+    {
+        levels.emplace_back();
+        levels.back().owned.reset(new Mesh(s / 2, mesh.meshtype, true));
+        levels.back().mesh = levels.back().owned.get();
+    }
 
-    // 构建对角矩阵
-    buildDiagMatrix(A0, D0);
+    for (size_t l = 0; l + 1 < levels.size(); ++l)
+    {
+        levels[l].P.reset(new CSRMatrix(MultiGrid::buildProlongation(*levels[l].mesh, *levels[l + 1].mesh)));
+        levels[l].R.reset(new CSRMatrix(transpose(*levels[l].P)));
+    }
 }
 
-void MultiGrid::projToCoarse(Vec &b, Mesh &m0, Vec &b1, Mesh &m1)
-/* 将b从细网格投影到粗网格上
- * 根据subdiv选取的特性，粗网格的顶点也是细网格的顶点
- * 直接使用对应顶点的值
- */
+static void allocateLevel(MultiGrid::Level &L, int n, bool fine)
+// 分配对角线与工作空间，第0层的x与b由solve传入；第0层使用外部算子时对角线在updateOperators中计算
 {
-    int subdivFine = m0.subdiv;
-    int subdivCoarse = m1.subdiv;
-    int *dd0 = m0.dupToNoDupIndex;
-    int *dd1 = m1.dupToNoDupIndex;
+    L.D.reset(new diagMatrix(n));
+    if (L.A)
+    {
+        buildDiagMatrix(*L.A, *L.D);
+    }
+    if (!fine)
+    {
+        L.x = Vec(n, 0.0);
+        L.b = Vec(n, 0.0);
+    }
+    L.r = Vec(n, 0.0);
+    L.p = Vec(n, 0.0);
+    L.Ap = Vec(n, 0.0);
+    L.preSmooth = 5;
+    L.postSmooth = 5;
+}
 
-    int N_fine = subdivFine + 1;
-    int N_coarse = subdivCoarse + 1;
-    int step = subdivFine / subdivCoarse;
+static CSRMatrix *galerkinCoarse(const MultiGrid::Level &fine)
+// 第l + 1层的算子 R A P，只依赖第l层，非零结构由符号计算得到
+{
+    return new CSRMatrix(tripleProduct(*fine.R, *fine.A, *fine.P));
+}
 
-    // 粗网格中的点 (row_c, col_c) 对应细网格中的点(row_c *step, col_c * step)
-    for (int face = 0; face < 6; ++face)
+static void assembleLevel(MultiGrid::Level &L)
+// 在本层网格上组装M与S，A与它们共享非零结构，数值在setCoefficients中组合
+{
+    NSMatrix *M = new NSMatrix(*L.mesh);
+    L.M.reset(M);
+    L.S.reset(new NSMatrix(*L.mesh, *M));
+    L.A.reset(new NSMatrix(*L.mesh, *M));
+    buildMassMatrix(*L.M, *L.mesh);
+    buildStiffnessMatrix(*L.S, *L.mesh);
+}
+
+MultiGrid::MultiGrid(Mesh &mesh, void funcBuildMatrix(NSMatrix &M), int coarseSubdiv, bool galerkin)
+    : mt(mesh.meshtype), subdiv(mesh.subdiv), w(0.6), tol(1e-6), cycleType(V), zeroMean(true), galerkin(galerkin), useSELL(false), alpha(0.0), beta(0.0), fineOp(nullptr)
+{
+    buildLevels(levels, mesh, coarseSubdiv);
+    for (size_t l = 0; l < levels.size(); ++l)
     {
-        int faceOffsetCoarse = face * N_coarse * N_coarse;
-        int faceOffsetFine = face * N_fine * N_fine;
-        // 遍历粗网格的行
-        for (int row_c = 0; row_c < N_coarse; ++row_c)
+        if (l == 0 || !galerkin)
         {
-            int row_f = row_c * step;
-            for (int col_c = 0; col_c < N_coarse; ++col_c)
-            {
-                int col_f = col_c * step;
+            // 根据传入的函数构建矩阵
+            NSMatrix *A = new NSMatrix(*levels[l].mesh);
+            levels[l].A.reset(A);
+            funcBuildMatrix(*A);
+        }
+        else
+        {
+            levels[l].A.reset(galerkinCoarse(levels[l - 1]));
+        }
+        allocateLevel(levels[l], levels[l].A->rows, l == 0);
+    }
+}
+
+MultiGrid::MultiGrid(Mesh &mesh, double alpha, double beta, int coarseSubdiv, bool galerkin)
+    : mt(mesh.meshtype), subdiv(mesh.subdiv), w(0.6), tol(1e-6), cycleType(V), zeroMean(true), galerkin(galerkin), useSELL(false), alpha(alpha), beta(beta), fineOp(nullptr)
+{
+    buildLevels(levels, mesh, coarseSubdiv);
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        Level &L = levels[l];
+        if (l == 0 || !galerkin)
+        {
+            assembleLevel(L);
+        }
+        else
+        {
+            L.A.reset(galerkinCoarse(levels[l - 1])); // 此时只有非零结构有意义，数值在setCoefficients中计算
+        }
+        allocateLevel(L, L.A->rows, l == 0);
+    }
+    this->alpha = NAN; // 保证下面重新组合
+    setCoefficients(alpha, beta);
+}
+
+MultiGrid::MultiGrid(Mesh &mesh, Matrix &fineOp, const Vec &diagM, const Vec &diagS, double alpha, double beta, int coarseSubdiv, bool galerkin)
+    : mt(mesh.meshtype), subdiv(mesh.subdiv), w(0.6), tol(1e-6), cycleType(V), zeroMean(true), galerkin(galerkin), useSELL(false), alpha(alpha), beta(beta),
+      fineOp(&fineOp), fineDiagM(diagM), fineDiagS(diagS)
+{
+    int n = mesh.vertex_count();
+    if (fineOp.rows != n || fineOp.cols != n || diagM.size != (size_t)n || diagS.size != (size_t)n)
+    {
+        throw std::invalid_argument("Size mismatch: MultiGrid fine operator does not match the mesh.");
+    }
+
+    buildLevels(levels, mesh, coarseSubdiv);
+    allocateLevel(levels[0], n, true); // 第0层只保存对角线与工作空间
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        Level &L = levels[l];
+        if (!galerkin)
+        {
+            assembleLevel(L);
+        }
+        else if (l == 1)
+        {
+            // 细层没有显式的矩阵，临时组装细层的M与S，得到第1层的 R M P 与 R S P 之后释放
+            const Level &F = levels[0];
+            NSMatrix M0(mesh);
+            NSMatrix S0(mesh, M0);
+            buildMassMatrix(M0);
+            buildStiffnessMatrix(S0);
+            L.M.reset(new CSRMatrix(tripleProduct(*F.R, M0, *F.P)));
+            L.S.reset(new CSRMatrix(*L.M)); // 与M共享非零结构
+            tripleProductNumeric(*F.R, S0, *F.P, *L.S);
+            L.A.reset(new CSRMatrix(*L.M));
+        }
+        else
+        {
+            L.A.reset(galerkinCoarse(levels[l - 1]));
+        }
+        allocateLevel(L, L.A->rows, false);
+    }
+    this->alpha = NAN; // 保证下面重新组合
+    setCoefficients(alpha, beta);
+}
+
+void MultiGrid::setFineOperator(Matrix &op)
+{
+    if (!fineOp)
+    {
+        throw std::logic_error("MultiGrid::setFineOperator: the fine level was built with its own matrix.");
+    }
+    if (op.rows != fineOp->rows || op.cols != fineOp->cols)
+    {
+        throw std::invalid_argument("Size mismatch: MultiGrid::setFineOperator requires the same size.");
+    }
+    fineOp = &op;
+}
+
+void MultiGrid::setCoefficients(double a, double b)
+{
+    if (!levels[0].M && !fineOp)
+    {
+        throw std::logic_error("MultiGrid::setCoefficients: levels were not built from M and S.");
+    }
+    if (a == alpha && b == beta) // 系数不变时A的值不变，不需要重新计算
+    {
+        return;
+    }
+    alpha = a;
+    beta = b;
+
+    for (Level &L : levels)
+    {
+        if (!L.M)
+        {
+            continue;
+        }
+        const double *m = L.M->elements.data;
+        const double *s = L.S->elements.data;
+        double *v = L.A->elements.data;
+#pragma omp parallel for
+        for (size_t t = 0; t < L.A->elements.size; ++t)
+        {
+            v[t] = a * m[t] + b * s[t];
+        }
+    }
+    updateOperators();
+}
 
-                int i = faceOffsetCoarse + row_c * N_coarse + col_c;
-                int t = faceOffsetFine + row_f * N_fine + col_f;
+void MultiGrid::updateOperators()
+{
+    for (size_t l = 0; l < levels.size(); ++l)
+    {
+        Level &L = levels[l];
+        if (!L.A)
+        {
+            // 外部算子的对角线由M与S的对角线组合，算子本身的系数由调用者设置
+            int n = fineDiagM.size;
+#pragma omp parallel for
+            for (int i = 0; i < n; ++i)
+            {
+                L.D->diag[i] = alpha * fineDiagM[i] + beta * fineDiagS[i];
+            }
+            continue;
+        }
+        if (galerkin && l > 0 && !L.M)
+        {
+            // 结构不变，只按已有结构重新计算数值
+            tripleProductNumeric(*levels[l - 1].R, *levels[l - 1].A, *levels[l - 1].P, *L.A);
+        }
+        buildDiagMatrix(*L.A, *L.D);
+        if (useSELL)
+        {
+            L.sell.update(*L.A);
+        }
+    }
+}
 
-                b1[dd1[i]] = b[dd0[t]];
+void MultiGrid::setSELL(bool sell, int sigma)
+{
+    useSELL = sell;
+    if (sell)
+    {
+        for (Level &L : levels)
+        {
+            if (L.A) // 外部算子不转换
+            {
+                L.sell = SELLMatrix(*L.A, sigma);
             }
         }
     }
 }
 
-void MultiGrid::projToFine(Vec &b, Mesh &m0, Vec &b1, Mesh &m1)
-// 将b从粗网格投影到细网格
+void MultiGrid::setSmoothing(int pre, int post)
 {
-    int subdivFine = m1.subdiv;
-    int subdivCoarse = m0.subdiv;
-    int *ddFine = m1.dupToNoDupIndex;
-    int *ddCoarse = m0.dupToNoDupIndex;
+    for (int l = 0; l < levelCount(); ++l)
+    {
+        setSmoothing(l, pre, post);
+    }
+}
 
-    int N_Fine = subdivFine + 1;
-    int N_Coarse = subdivCoarse + 1;
-    int step = subdivFine / subdivCoarse;
+void MultiGrid::setSmoothing(int l, int pre, int post)
+{
+    if (l < 0 || l >= levelCount())
+    {
+        throw std::out_of_range("MultiGrid::setSmoothing: level out of range.");
+    }
+    levels[l].preSmooth = pre;
+    levels[l].postSmooth = post;
+}
+
+Matrix &MultiGrid::op(int l)
+{
+    if (!levels[l].A)
+    {
+        return *fineOp;
+    }
+    return useSELL ? (Matrix &)levels[l].sell : (Matrix &)*levels[l].A;
+}
+
+CSRMatrix MultiGrid::buildProlongation(Mesh &fine, Mesh &coarse)
+/* 细网格的每个点位于粗网格的某个三角形内，P的一行为该点关于这个三角形三个顶点的线性插值系数
+ * 每个单元的对角线方向与load_cube一致: 面1, 2, 4为(i, j)到(i+1, j+1)，其余为(i, j+1)到(i+1, j)
+ * 相邻面共享的点在dupToNoDupIndex中出现多次，各面给出的系数相同，只处理第一次
+ */
+{
+    int *ddFine = fine.dupToNoDupIndex;
+    int *ddCoarse = coarse.dupToNoDupIndex;
+    int N_Fine = fine.subdiv + 1;
+    int N_Coarse = coarse.subdiv + 1;
+    int step = fine.subdiv / coarse.subdiv;
+    int rows = fine.vertex_count();
+
+    // 每行最多3个非零元
+    std::vector<uint32_t> col(3 * (size_t)rows);
+    std::vector<double> val(3 * (size_t)rows);
+    std::vector<uint8_t> len(rows, 0);
 
     for (int face = 0; face < 6; ++face)
     {
         int faceOffsetCoarse = face * N_Coarse * N_Coarse;
         int faceOffsetFine = face * N_Fine * N_Fine;
+        bool mainDiagonal = (face == 1 || face == 2 || face == 4);
 
         for (int row_f = 0; row_f < N_Fine; ++row_f)
         {
-            // 计算当前行对应的粗网格行，以及上下两行
-            float row_c_f = (float)row_f / step;
-            int row_c0 = (int)std::floor(row_c_f);           // 细网格行对应的粗网格的下方一行
-            int row_c1 = std::min(row_c0 + 1, N_Coarse - 1); // 上方一行，需要避免超出范围
-            float dy = row_c_f - row_c0;                     // 用于双线性插值
-
+            int row_c = row_f / step;
+            double dy = (double)(row_f % step) / step;
             for (int col_f = 0; col_f < N_Fine; ++col_f)
             {
-                // 类似的计算当前列对应的粗网格的列
-                float col_c_f = (float)col_f / step;
-                int col_c0 = (int)std::floor(col_c_f);
-                int col_c1 = std::min(col_c0 + 1, N_Coarse - 1);
-                float dx = col_c_f - col_c0;
-
-                int t = faceOffsetFine + row_f * N_Fine + col_f;
-                int idx_f = ddFine[t];
+                int idx_f = ddFine[faceOffsetFine + row_f * N_Fine + col_f];
+                if (len[idx_f])
+                {
+                    continue;
+                }
+                int col_c = col_f / step;
+                double dx = (double)(col_f % step) / step;
 
-                if (row_f % step == 0 && col_f % step == 0) // 细网格点与粗网格点重合，直接使用粗网格的值
+                // 单元四个角的权重，00为(row_c, col_c)，01为(row_c, col_c + 1)，10为(row_c + 1, col_c)
+                double w00 = 0, w01 = 0, w10 = 0, w11 = 0;
+                if (mainDiagonal)
                 {
-                    int i = faceOffsetCoarse + row_c0 * N_Coarse + col_c0;
-                    b1[idx_f] = b[ddCoarse[i]];
+                    if (dx >= dy)
+                    {
+                        w00 = 1 - dx;
+                        w01 = dx - dy;
+                        w11 = dy;
+                    }
+                    else
+                    {
+                        w00 = 1 - dy;
+                        w10 = dy - dx;
+                        w11 = dx;
+                    }
+                }
+                else if (dx + dy <= 1)
+                {
+                    w00 = 1 - dx - dy;
+                    w01 = dx;
+                    w10 = dy;
                 }
                 else
                 {
-                    // 使用双线性插值
-                    int i00 = faceOffsetCoarse + row_c0 * N_Coarse + col_c0;
-                    int i01 = faceOffsetCoarse + row_c1 * N_Coarse + col_c0;
-                    int i10 = faceOffsetCoarse + row_c0 * N_Coarse + col_c1;
-                    int i11 = faceOffsetCoarse + row_c1 * N_Coarse + col_c1;
-
-                    int idx00 = ddCoarse[i00];
-                    int idx01 = ddCoarse[i01];
-                    int idx10 = ddCoarse[i10];
-                    int idx11 = ddCoarse[i11];
-
-                    double v00 = b[idx00];
-                    double v01 = b[idx01];
-                    double v10 = b[idx10];
-                    double v11 = b[idx11];
-
-                    // 双线性插值，先对x进行插值，再对y进行插值
-                    double v0 = v00 * (1 - dx) + v10 * dx;
-                    double v1 = v01 * (1 - dx) + v11 * dx;
-                    double v = v0 * (1 - dy) + v1 * dy;
-
-                    b1[idx_f] = v;
+                    w01 = 1 - dy;
+                    w10 = 1 - dx;
+                    w11 = dx + dy - 1;
+                }
+
+                // 权重为零的角可能在网格之外，不访问
+                const double w[4] = {w00, w01, w10, w11};
+                const int dr[4] = {0, 0, 1, 1};
+                const int dc[4] = {0, 1, 0, 1};
+                size_t pos = 3 * (size_t)idx_f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    if (w[k] > 0)
+                    {
+                        col[pos + len[idx_f]] = ddCoarse[faceOffsetCoarse + (row_c + dr[k]) * N_Coarse + col_c + dc[k]];
+                        val[pos + len[idx_f]] = w[k];
+                        ++len[idx_f];
+                    }
                 }
             }
         }
     }
+
+    auto pattern = std::make_shared<CSRPattern>(rows);
+    for (int r = 0; r < rows; ++r)
+    {
+        pattern->row_offset[r + 1] = pattern->row_offset[r] + len[r];
+    }
+    pattern->elm_idx.resize(pattern->row_offset[rows]);
+    CSRMatrix P(rows, coarse.vertex_count(), pattern);
+
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r)
+    {
+        // 每行按列下标插入排序
+        uint32_t first = pattern->row_offset[r];
+        for (int a = 0; a < len[r]; ++a)
+        {
+            int b = a;
+            for (; b > 0 && pattern->elm_idx[first + b - 1] > col[3 * (size_t)r + a]; --b)
+            {
+                pattern->elm_idx[first + b] = pattern->elm_idx[first + b - 1];
+                P.elements[first + b] = P.elements[first + b - 1];
+            }
+            pattern->elm_idx[first + b] = col[3 * (size_t)r + a];
+            P.elements[first + b] = val[3 * (size_t)r + a];
+        }
+    }
+    return P;
 }
 
-void MultiGrid::dumpedJacobi(const NSMatrix &A, const diagMatrix &D, const Vec &b, Vec &x, Vec &r, int iter = 5)
+void MultiGrid::dumpedJacobi(const Matrix &A, const diagMatrix &D, const Vec &b, Vec &x, Vec &r, Vec &p, int iter = 5)
 {
-    Vec p(x.size); // 临时空间
-
     for (int i = 0; i < iter; ++i)
     {
         A.MVP(x, p);
@@ -145,7 +393,7 @@ void MultiGrid::dumpedJacobi(const NSMatrix &A, const diagMatrix &D, const Vec &
     }
 }
 
-void MultiGrid::conjugateGraidentSmooth(NSMatrix &A, Vec &b, Vec &x, int iter = 5)
+void MultiGrid::conjugateGraidentSmooth(Matrix &A, Vec &b, Vec &x, int iter = 5)
 {
     int cg_iter;
     double cg_rel_error;
@@ -154,55 +402,77 @@ void MultiGrid::conjugateGraidentSmooth(NSMatrix &A, Vec &b, Vec &x, int iter =
 }
 
 /* 我们希望在最细网格上求解Ax = b
- * 预平滑后计算残差，将残差限制到下一层网格，求解Ae = r得到误差e
- * 将e插值回到细网格，更新x = x + e
+ * 预平滑后计算残差，将残差限制到下一层网格，递归地求解Ae = r得到误差e
+ * 将e插值回到细网格，更新x = x + e，再进行后平滑
+ * 最粗层用CG求解
  */
+void MultiGrid::cycle(int l, const Vec &b, Vec &x, CycleType type)
+{
+    Level &L = levels[l];
+    Matrix &A = op(l);
+
+    if (l == levelCount() - 1)
+    {
+        if (&b != &L.b) // 只有一层时b来自外部，复制后再修改
+            L.b = b;
+        if (zeroMean)
+            setZeroMean(L.b);
+        int cg_iter;
+        double cg_rel_error;
+        conjugateGradientSolve(A, L.b, x, L.r, L.p, L.Ap, &cg_rel_error, &cg_iter, tol);
+        return;
+    }
+
+    dumpedJacobi(A, *L.D, b, x, L.r, L.p, L.preSmooth); // 预平滑
+    A.MVP(x, L.p);
+    blas_axpby(1.0, b, -1.0, L.p, L.r); // 计算残差
+
+    Level &C = levels[l + 1];
+    L.R->MVP(L.r, C.b); // 限制到粗网格
+    std::fill(C.x.begin(), C.x.end(), 0.0);
+    cycle(l + 1, C.b, C.x, type);
+    if (type == W)
+        cycle(l + 1, C.b, C.x, W);
+    else if (type == F)
+        cycle(l + 1, C.b, C.x, V);
+
+    // 插值回到细网格
+    L.P->MVP(C.x, L.p);
+    if (zeroMean)
+        setZeroMean(L.p);
+    blas_axpby(1.0, x, 1.0, L.p, x);
+
+    dumpedJacobi(A, *L.D, b, x, L.r, L.p, L.postSmooth); // 后平滑
+}
+
 void MultiGrid::solve(Vec &b, Vec &x)
 {
     double b_norm = b.norm();
     double rel_error;
     int iter = 0;
     int iterMax = 1000;
-    Vec p0(x.size);
-    Vec p3(r3.size), Ap3(r3.size), t3(r3.size);
-    Vec e3(r3.size, 0.0), e2(r2.size, 0.0), e1(r1.size, 0.0);
+    Level &L = levels[0];
+    Matrix &A = op(0);
     while (iter++ < iterMax)
     {
-        // 计算残差并限制
-        // conjugateGraidentSmooth(A0, b, x, 10); // 预平滑
-        dumpedJacobi(A0, D0, b, x, r0);
-
-        A0.MVP(x, p0);
-        blas_axpby(1.0, b, -1.0, p0, r0); // 计算残差
-        rel_error = r0.norm() / b_norm;
+        A.MVP(x, L.p);
+        blas_axpby(1.0, b, -1.0, L.p, L.r); // 计算残差
+        rel_error = L.r.norm() / b_norm;
         std::cout << "iter :" << iter << " rel_error: " << rel_error << std::endl;
 
         if (rel_error < this->tol)
             break;
 
-        projToCoarse(r0, m0, r1, m1); // 限制到粗网格m1
-        projToCoarse(r1, m1, r2, m2);
-        projToCoarse(r2, m2, r3, m3);
-        setZeroMean(r3);
-
-        // 在最粗网格上直接求解Ae = r
-        int cg_iter;
-        double cg_rel_error;
-        conjugateGradientSolve(A3, r3, e3, t3, p3, Ap3, &cg_rel_error, &cg_iter, tol);
-        // std::cout << "cg_rel_error: " << cg_rel_error << std::endl;
-
-        // 插值回到细网格
-        projToFine(e3, m3, e2, m2);
-        projToFine(e2, m2, e1, m1);
-        projToFine(e1, m1, p0, m0);
-        setZeroMean(p0);
-        blas_axpby(1.0, x, 1.0, p0, x);
-
-        // conjugateGraidentSmooth(A0, b, x, 10); // 后平滑
-        dumpedJacobi(A0, D0, b, x, r0);
+        cycle(0, b, x, cycleType);
     }
 }
 
+void MultiGridPreconditioner::apply(const Vec &r, Vec &z) const
+{
+    std::fill(z.begin(), z.end(), 0.0);
+    mg.cycle(0, r, z, mg.cycleType);
+}
+
 void MultiGrid::setZeroMean(Vec &x)
 {
     double mean = x.sum() / (double)x.size;
@@ -212,32 +482,3 @@ void MultiGrid::setZeroMean(Vec &x)
         x[t] -= mean;
     }
 }
-
-// void MultiGrid::solve(Vec &b, Vec &x)
-// {
-//     Vec x1(A1.rows, 0.0), x2(A2.rows, 0.0), x3(A3.rows, 0.0);
-//     Vec p1(A1.rows, 0.0), p2(A2.rows, 0.0), p3(A3.rows, 0.0);
-//     Vec Ap1(A1.rows, 0.0), Ap2(A2.rows, 0.0), Ap3(A3.rows, 0.0);
-//     Vec b1(A1.rows, 0.0), b2(A2.rows, 0.0), b3(A3.rows, 0.0);
-//     Vec p0(x.size), Ap0(x.size);
-//     projToCoarse(b, m0, b1, m1);
-//     projToCoarse(b, m0, b2, m2);
-//     projToCoarse(b, m0, b3, m3);
-//     setZeroMean(b1);
-//     setZeroMean(b2);
-//     setZeroMean(b3);
-
-//     double rel_err;
-//     int iter;
-//     conjugateGradientSolve(A3, b3, x3, r3, p3, Ap3, &rel_err, &iter, tol, 10000);
-//     std::cout << "iter: " << iter << " rel_err: " << rel_err <<std::endl;
-//     projToFine(x3, m3, x2, m2);
-//     conjugateGradientSolve(A2, b2, x2, r2, p2, Ap2, &rel_err, &iter, tol, 10000);
-//     std::cout << "iter: " << iter << " rel_err: " << rel_err <<std::endl;
-//     projToFine(x2, m2, x1, m1);
-//     conjugateGradientSolve(A1, b1, x1, r1, p1, Ap1, &rel_err, &iter, tol, 10000);
-//     std::cout << "iter: " << iter << " rel_err: " << rel_err << std::endl;
-//     projToFine(x1, m1, x, m0);
-//     conjugateGradientSolve(A0, b, x, r0, p0, Ap0, &rel_err, &iter, tol, 10000);
-//     std::cout << "iter: " << iter << " rel_err: " << rel_err << std::endl;
-// }
\ No newline at end of file
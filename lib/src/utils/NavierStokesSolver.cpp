@@ -7,23 +7,28 @@
 #include <systemSolve.h>
 #include <iostream>
 #include <timer.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
 
-NavierStokesSolver::NavierStokesSolver(int subdiv, MeshType meshtype)
-    : mesh(subdiv, meshtype, true), M(mesh), S(mesh), A(mesh), Omega(M.rows, 0), MOmega(M.rows, 0), Psi(M.rows, 0), T(M.rows, 0), r(M.rows, 0), p(M.rows, 0), Ap(M.rows, 0),
-      cholesky()
+NavierStokesSolver::NavierStokesSolver(int subdiv, MeshType meshtype, const std::string &cacheDir)
+    : mesh(subdiv, meshtype, true), M(mesh), S(mesh, M), A(M, S), Omega(M.rows, 0), MOmega(M.rows, 0), Psi(M.rows, 0), T(M.rows, 0), r(M.rows, 0), p(M.rows, 0), Ap(M.rows, 0),
+      cholesky(), directSolve(false), maxFactors(4), useSELL(false), useStencil(false), useMG(false), symmetric(false)
 {
     t = 0;
     tol = 1e-6;
     buildMassMatrix(M);
     buildStiffnessMatrix(S);
     vol = M.elements.sum();
+    cholesky.setOrdering(Cholesky::RCM);
+    cholesky.setCacheDir(cacheDir);
     cholesky.attach(S, 1e-10);
     cholesky.compute();
 }
 
 void NavierStokesSolver::computeStream(int *iter)
 {
-    M.MVP(Omega, MOmega);
+    massMVP(Omega, MOmega);
     MOmega.scaleInPlace(-1.0);
     setZeroMean(MOmega);
     cholesky.solve(MOmega, Psi);
@@ -46,7 +51,7 @@ void NavierStokesSolver::setZeroMean(Vec &x)
     // {
     //     x[t] -= mean;
     // }
-    M.MVP(x, Ap);
+    massMVP(x, Ap);
     double s = Ap.sum() / vol;
     for (int i = 0; i < Ap.size; ++i)
     {
@@ -59,18 +64,42 @@ void NavierStokesSolver::computeTransport()
 {
     T.setAll(0.0);
 
-    for (size_t t = 0; t < mesh.triangle_count(); ++t)
+    // 按三角形着色并行，同一颜色的三角形没有公共顶点；无法着色时用原子操作累加
+    if (omp_get_max_threads() > 1 && !mesh.ensureColoring())
     {
-        uint32_t a = mesh.indices[3 * t + 0];
-        uint32_t b = mesh.indices[3 * t + 1];
-        uint32_t c = mesh.indices[3 * t + 2];
+        size_t ntri = mesh.triangle_count();
+#pragma omp parallel for
+        for (size_t t = 0; t < ntri; ++t)
+        {
+            uint32_t a = mesh.indices[3 * t + 0];
+            uint32_t b = mesh.indices[3 * t + 1];
+            uint32_t c = mesh.indices[3 * t + 2];
 
-        double sum = Omega[a] + Omega[b] + Omega[c];
-        T[a] += sum * (Psi[b] - Psi[c]);
-        T[b] += sum * (Psi[c] - Psi[a]);
-        T[c] += sum * (Psi[a] - Psi[b]);
+            double sum = Omega[a] + Omega[b] + Omega[c];
+#pragma omp atomic
+            T[a] += sum * (Psi[b] - Psi[c]);
+#pragma omp atomic
+            T[b] += sum * (Psi[c] - Psi[a]);
+#pragma omp atomic
+            T[c] += sum * (Psi[a] - Psi[b]);
+        }
+    }
+    else
+    {
+        mesh.forEachTriangleColored([&](uint32_t t)
+        {
+            uint32_t a = mesh.indices[3 * t + 0];
+            uint32_t b = mesh.indices[3 * t + 1];
+            uint32_t c = mesh.indices[3 * t + 2];
+
+            double sum = Omega[a] + Omega[b] + Omega[c];
+            T[a] += sum * (Psi[b] - Psi[c]);
+            T[b] += sum * (Psi[c] - Psi[a]);
+            T[c] += sum * (Psi[a] - Psi[b]);
+        });
     }
 
+#pragma omp parallel for
     for (size_t t = 0; t < T.size; ++t)
     {
         T[t] *= 1.0 / 6;
@@ -86,15 +115,211 @@ void NavierStokesSolver::timeStep(double dt, double nu)
 
     computeStream(&iter1);
     computeTransport();
-    M.MVP(Omega, p);
+    massMVP(Omega, p);
     blas_axpby(1.0, p, dt, T, MOmega);
     // MOmega = MOmega + dt * T;
-    blas_addMatrix(S, dt * nu, M, A);
-    // A = M + dt * nu * S
+    if (directSolve)
+    {
+        factorFor(dt * nu).solve(MOmega, Omega);
+        iter2 = 0;
+    }
+    else
+    {
+        // A = M + dt * nu * S，多重网格的最细层也使用A或Asym，系数总是需要更新
+        Matrix *Aop = &A;
+        if (symmetric)
+        {
+            Asym->setCoefficients(1.0, dt * nu);
+            Aop = Asym.get();
+        }
+        else
+        {
+            A.setCoefficients(1.0, dt * nu);
+            if (useStencil)
+            {
+                Astencil.update(M, 1.0, S, dt * nu);
+                Aop = &Astencil;
+            }
+            else if (useSELL)
+            {
+                Asell.update(M, 1.0, S, dt * nu);
+                Aop = &Asell;
+            }
+        }
 
-    conjugateGradientSolve(A, MOmega, Omega, r, p, Ap, &rel_error, &iter2, tol, 1000);
+        if (useMG)
+        {
+            mg->setCoefficients(1.0, dt * nu);
+            preconditionedConjugateGradientSolve(*Aop, *mgPrecond, MOmega, Omega, r, z, p, Ap, &rel_error, &iter2, tol, 1000);
+        }
+        else
+        {
+            conjugateGradientSolve(*Aop, MOmega, Omega, r, p, Ap, &rel_error, &iter2, tol, 1000);
+        }
+    }
     setZeroMean(Omega);
     t += dt;
     std::cout << "Iter2: " << iter2;
     timer.stop(" total time");
+}
+
+void NavierStokesSolver::setDirectSolve(bool direct, size_t cacheSize)
+{
+    if (direct && symmetric)
+    {
+        throw std::logic_error("NavierStokesSolver: direct solve needs the full M and S, disable setSymmetric first.");
+    }
+    directSolve = direct;
+    maxFactors = std::max(cacheSize, (size_t)1);
+    factors.clear();
+    if (direct && symbolicA.value_pos.size == 0) // 符号分解只需要做一次
+    {
+        symbolicA.setOrdering(Cholesky::RCM);
+        symbolicA.analyze(M); // A与M的结构相同
+    }
+}
+
+void NavierStokesSolver::setSELL(bool sell, int sigma)
+{
+    if (sell && symmetric)
+    {
+        throw std::logic_error("NavierStokesSolver: SELL needs the full M and S, disable setSymmetric first.");
+    }
+    useSELL = sell;
+    if (sell)
+    {
+        Asell = SELLMatrix(M, sigma); // 只使用M的结构，数值在timeStep中更新
+    }
+}
+
+void NavierStokesSolver::setStencil(bool stencil)
+{
+    if (stencil && symmetric)
+    {
+        throw std::logic_error("NavierStokesSolver: the stencil format needs the full M and S, disable setSymmetric first.");
+    }
+    useStencil = stencil;
+    if (stencil)
+    {
+        Astencil = StencilMatrix(mesh, M); // 只使用M的结构，数值在timeStep中更新
+    }
+}
+
+void NavierStokesSolver::setMultiGrid(bool multigrid, MultiGrid::CycleType type, int smooth, int coarseSubdiv, bool galerkin)
+{
+    useMG = multigrid;
+    if (multigrid)
+    {
+        // 最细层直接使用A或Asym，只需要M与S的对角线
+        int n = M.rows;
+        Vec diagM(n), diagS(n);
+#pragma omp parallel for
+        for (int i = 0; i < n; ++i)
+        {
+            if (symmetric) // 每行的第一个元素为对角元
+            {
+                diagM[i] = Msym.elements[Msym.row_offset[i]];
+                diagS[i] = Ssym[Msym.row_offset[i]];
+            }
+            else
+            {
+                diagM[i] = M(i, i);
+                diagS[i] = S(i, i);
+            }
+        }
+        Matrix &fine = symmetric ? (Matrix &)*Asym : (Matrix &)A;
+        mg.reset(new MultiGrid(mesh, fine, diagM, diagS, 1.0, 0.0, coarseSubdiv, galerkin)); // 系数在timeStep中设置
+        mg->zeroMean = false;                                                                 // A = M + dt * nu * S 非奇异
+        mg->setCycle(type);
+        mg->setSmoothing(smooth, smooth);                                                     // 前后平滑次数相同，预条件子对称
+        mgPrecond.reset(new MultiGridPreconditioner(*mg));
+        z = Vec(M.rows, 0.0);
+    }
+    else
+    {
+        mgPrecond.reset();
+        mg.reset();
+    }
+}
+
+void NavierStokesSolver::setSymmetric(bool sym)
+{
+    if (sym == symmetric)
+    {
+        return;
+    }
+    if (sym && (directSolve || useSELL || useStencil))
+    {
+        throw std::logic_error("NavierStokesSolver: setSymmetric cannot be combined with direct solve, SELL or the stencil format.");
+    }
+
+    symmetric = sym;
+    if (sym)
+    {
+        Msym = SymCSRMatrix(M);
+        Msym.extract(S, Ssym);
+        Asym.reset(new SymLinearCombinationMatrix(Msym, Ssym));
+
+        // 释放完整存储的数值与M, S共享的非零结构
+        M.elements = Vec();
+        S.elements = Vec();
+        *M.pattern = CSRPattern(M.rows);
+    }
+    else
+    {
+        // 重新建立非零结构并组装，结构与构造时相同
+        *M.pattern = CSRPattern(mesh);
+        M.elements = Vec(M.elm_idx.size, 0.0);
+        S.elements = Vec(M.elm_idx.size, 0.0);
+        buildMassMatrix(M);
+        buildStiffnessMatrix(S);
+
+        Asym.reset();
+        Msym = SymCSRMatrix();
+        Ssym = Vec();
+    }
+    if (mg) // 多重网格的最细层指向当前使用的A，数值不变
+    {
+        mg->setFineOperator(sym ? (Matrix &)*Asym : (Matrix &)A);
+    }
+}
+
+void NavierStokesSolver::massMVP(const Vec &x, Vec &y) const
+{
+    if (symmetric)
+        Msym.MVP(x, y);
+    else
+        M.MVP(x, y);
+}
+
+Cholesky &NavierStokesSolver::factorFor(double c)
+/* 命中时移动到链表头部
+ * 未命中时，缓存未满则复制符号分解，已满则复用最久未使用的分解的空间，只进行数值分解
+ */
+{
+    for (auto it = factors.begin(); it != factors.end(); ++it)
+    {
+        if (it->first == c)
+        {
+            factors.splice(factors.begin(), factors, it);
+            return factors.front().second;
+        }
+    }
+
+    if (factors.size() < maxFactors)
+    {
+        factors.emplace_front(c, symbolicA);
+    }
+    else
+    {
+        factors.splice(factors.begin(), factors, std::prev(factors.end()));
+        factors.front().first = c;
+    }
+
+    // 直接法需要显式的矩阵，临时组装 M + c * S，与M共享结构
+    // 分解不保留对Ac的引用，Ac可以是临时对象
+    CSRMatrix Ac(M.rows, M.pattern);
+    LinearCombinationMatrix(M, S, 1.0, c).assemble(Ac);
+    factors.front().second.factorize(Ac);
+    return factors.front().second;
 }
\ No newline at end of file
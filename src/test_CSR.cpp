@@ -4,6 +4,12 @@
 #include <fem.h>
 #include <time.h>
 #include <systemSolve.h>
+#include <preconditioner.h>
+#include <incompleteCholesky.h>
+#include <amg.h>
+#include <SELLMatrix.h>
+#include <SymCSRMatrix.h>
+#include <StencilMatrix.h>
 #include <omp.h>
 #include <string.h>
 #include <cmath>
@@ -78,17 +84,131 @@ int main(int argc, char *argv[])
     Vec Ar(n);
     Vec p(n);
     Vec Ap(n);
+    Vec w(n);
+    Vec z(n);
 
     fill_rhs(mesh, f);
     M.MVP(f, B);
 
     double rel_error;
     int iter;
-    std::cout << "开始求解";
+    std::cout << "开始求解" << std::endl;
     t.start();
-    conjugateGradientSolve(S, B, u, r, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    if (argc > 4 && strncmp(argv[4], "pipelined", 9) == 0)
+    {
+        pipelinedConjugateGradientSolve(S, B, u, r, p, Ap, w, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "jacobi", 6) == 0)
+    {
+        JacobiPreconditioner P(S);
+        preconditionedConjugateGradientSolve(S, P, B, u, r, z, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "ssor", 4) == 0)
+    {
+        SSORPreconditioner P(S, 1.2);
+        preconditionedConjugateGradientSolve(S, P, B, u, r, z, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "poly", 4) == 0)
+    {
+        PolynomialPreconditioner P(S, 3);
+        preconditionedConjugateGradientSolve(S, P, B, u, r, z, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "ic", 2) == 0)
+    {
+        int level = (argc > 5) ? atoi(argv[5]) : 0;
+        IncompleteCholesky P(S, level);
+        t.stop("IC分解用时");
+        std::cout << "IC(" << level << ") nnz: " << P.nnz() << std::endl;
+        t.start();
+        preconditionedConjugateGradientSolve(S, P, B, u, r, z, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "amg", 3) == 0)
+    {
+        double theta = (argc > 5) ? atof(argv[5]) : 0.08;
+        AMGPreconditioner P(S, theta);
+        if (argc > 6)
+            P.smooth = atoi(argv[6]);
+        t.stop("AMG setup用时");
+        std::cout << "AMG levels: " << P.levelCount() << " operator complexity: " << P.operatorComplexity() << std::endl;
+        for (int l = 0; l < P.levelCount(); ++l)
+            std::cout << "  level " << l << ": " << P.levels[l].A->rows << " rows, nnz " << P.levels[l].A->elements.size << std::endl;
+        t.start();
+        P.update(S);
+        t.stop("AMG update用时");
+        t.start();
+        preconditionedConjugateGradientSolve(S, P, B, u, r, z, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "sell", 4) == 0)
+    {
+        int sigma = (argc > 5) ? atoi(argv[5]) : 1;
+        SELLMatrix E(S, sigma);
+        t.stop("SELL转换用时");
+        std::cout << "SELL-" << SELLMatrix::C << "-" << sigma << " fill ratio: " << E.fillRatio() << std::endl;
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            S.MVP(f, Ar);
+        t.stop("CSR MVP x100");
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            E.MVP(f, Ap);
+        t.stop("SELL MVP x100");
+        std::cout << "|y_csr - y_sell|: " << (Ar - Ap).norm() << std::endl;
+        t.start();
+        conjugateGradientSolve(E, B, u, r, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "sym", 3) == 0)
+    {
+        SymCSRMatrix E(S);
+        t.stop("对称存储转换用时");
+        std::cout << "nnz: " << E.elements.size << " / " << S.elements.size << ", parts: " << E.nparts << ", window: " << E.window.size << std::endl;
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            S.MVP(f, Ar);
+        t.stop("CSR MVP x100");
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            E.MVP(f, Ap);
+        t.stop("Sym MVP x100");
+        std::cout << "|y_csr - y_sym|: " << (Ar - Ap).norm() << std::endl;
+        // 分段越多，跨段写入越多，窗口长度受限，更远的元素单独累加
+        for (int parts : {1, 4, 8, 16})
+        {
+            SymCSRMatrix Ep(S, parts);
+            t.start();
+            for (int k = 0; k < 100; ++k)
+                Ep.MVP(f, Ap);
+            t.stop("Sym MVP x100");
+            std::cout << "  parts: " << Ep.nparts << ", window: " << Ep.window.size << " (" << (double)Ep.window.size / Ep.elements.size << " of nnz)"
+                      << ", far: " << Ep.far_row.size << ", |y_csr - y_sym|: " << (Ar - Ap).norm() << std::endl;
+        }
+        t.start();
+        conjugateGradientSolve(E, B, u, r, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else if (argc > 4 && strncmp(argv[4], "stencil", 7) == 0)
+    {
+        Mesh grid(subdiv, mesh.meshtype, true); // 需要dupToNoDupIndex，顶点编号与mesh相同
+        StencilMatrix E(grid, S);
+        t.stop("模板转换用时");
+        std::cout << "core rows: " << E.coreRows() << " / " << E.rows << ", seam nnz: " << E.seam_idx.size << std::endl;
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            S.MVP(f, Ar);
+        t.stop("CSR MVP x100");
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            E.MVP(f, Ap);
+        t.stop("Stencil MVP x100");
+        std::cout << "|y_csr - y_stencil|: " << (Ar - Ap).norm() << std::endl;
+        t.start();
+        conjugateGradientSolve(E, B, u, r, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
+    else
+    {
+        conjugateGradientSolve(S, B, u, r, p, Ap, &rel_error, &iter, 1e-6, 100000);
+    }
     t.stop();
     std::cout << "用时: " << t.elapsedMilliseconds() << "ms" << std::endl;
+    std::cout << "iter: " << iter << " rel_error: " << rel_error << std::endl;
 
     std::cout << "u[n - 1]: " << u[n - 1] << std::endl;
 }
@@ -44,7 +44,7 @@ int main(int argc, char *argv[])
     }
     else if (argc == 2)
     {
-        std::cerr << "Usage: " << argv[0] << " {cube/sphere} subdiv " << std::endl;
+        std::cerr << "Usage: " << argv[0] << " {cube/sphere} subdiv [V/W/F]" << std::endl;
         return 0;
     }
     else if (argc > 2)
@@ -74,7 +74,11 @@ int main(int argc, char *argv[])
     }
     std::cout << "b initialized" << std::endl;
     MultiGrid mg(m0, buildMassMatrix);
-    std::cout << "MultiGrid initialized" << std::endl;
+    if (argc > 3) // 循环类型 V/W/F
+    {
+        mg.setCycle(argv[3][0] == 'W' ? MultiGrid::W : (argv[3][0] == 'F' ? MultiGrid::F : MultiGrid::V));
+    }
+    std::cout << "MultiGrid initialized, levels: " << mg.levelCount() << std::endl;
     Vec x(b.size, 0);
     t.stop("用时");
     t.start();
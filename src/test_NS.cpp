@@ -42,7 +42,7 @@ int main(int argc, char *argv[])
     }
     else if (argc == 2)
     {
-        std::cerr << "Usage: " << argv[0] << " {cube/sphere} subdiv " << std::endl;
+        std::cerr << "Usage: " << argv[0] << " {cube/sphere} subdiv [direct/mg]" << std::endl;
         return 0;
     }
     else if (argc > 2)
@@ -63,6 +63,14 @@ int main(int argc, char *argv[])
         }
     }
     NavierStokesSolver Solver(subdiv, mt);
+    if (argc > 3 && std::strcmp(argv[3], "direct") == 0)
+    {
+        Solver.setDirectSolve(true);
+    }
+    else if (argc > 3 && std::strcmp(argv[3], "mg") == 0)
+    {
+        Solver.setMultiGrid(true);
+    }
     for (size_t i = 0; i < Solver.Omega.size; ++i)
     {
         Solver.Omega[i] = test_f(Solver.mesh.vertices[i], 0.5, 1.5);
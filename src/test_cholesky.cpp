@@ -1,4 +1,5 @@
 #include <cholesky.h>
+#include <supernodalCholesky.h>
 #include <iostream>
 #include <CSRMatrix.h>
 #include <Mesh.h>
@@ -112,6 +113,141 @@ int main()
     chol3.solve(B,x);
     std::cout << "x: " << x << std::endl;
 
+    // 比较重排前后的包络大小与求解结果
+    {
+        Mesh mesh(40, SPHERE);
+        CSRMatrix S(mesh);
+        CSRMatrix M(mesh);
+        buildStiffnessMatrix(S, mesh);
+        buildMassMatrix(M, mesh);
+        addMassToStiffness(S, M);
+
+        Vec b(S.rows, 1.0), xn(S.rows), xr(S.rows), Ax(S.rows);
+        Timer t;
+        for (int o = 0; o < 2; ++o)
+        {
+            Cholesky chol;
+            chol.setOrdering(o == 0 ? Cholesky::Natural : Cholesky::RCM);
+            t.start();
+            chol.attach(S);
+            chol.compute();
+            t.stop(o == 0 ? "Natural 分解用时" : "RCM 分解用时");
+            chol.solve(b, o == 0 ? xn : xr);
+            std::cout << "包络大小: " << chol.envelopeBefore << " -> " << chol.envelopeAfter << std::endl;
+
+            if (o == 1)
+            {
+                // 比较串行与分块并行的前代回代
+                Vec xp(S.rows);
+                chol.setParallelSolve(false);
+                t.start();
+                for (int k = 0; k < 10; ++k)
+                {
+                    chol.solve(b, xr);
+                }
+                t.stop("串行求解10次用时");
+                chol.setParallelSolve(true);
+                t.start();
+                for (int k = 0; k < 10; ++k)
+                {
+                    chol.solve(b, xp);
+                }
+                t.stop("并行求解10次用时");
+                std::cout << "串行与并行求解的差: " << (xp - xr).norm() << std::endl;
+            }
+        }
+        {
+            // 逐列并行的分解
+            Cholesky chol;
+            chol.setOrdering(Cholesky::RCM);
+            chol.setTaskFactor(false);
+            chol.attach(S);
+            t.start();
+            chol.compute();
+            t.stop("RCM 逐列分解用时");
+            Vec xc(S.rows);
+            chol.solve(b, xc);
+            std::cout << "逐列分解与任务分解的差: " << (xc - xr).norm() << std::endl;
+        }
+        {
+            // 第一次分解后写入缓存，第二次直接映射缓存文件
+            Vec xc(S.rows);
+            for (int k = 0; k < 2; ++k)
+            {
+                Cholesky chol;
+                chol.setOrdering(Cholesky::RCM);
+                chol.setCacheDir("cholesky_cache");
+                chol.attach(S);
+                t.start();
+                chol.compute();
+                t.stop(chol.fromCache ? "从缓存读取用时" : "分解并写入缓存用时");
+                chol.solve(b, xc);
+            }
+            std::cout << "缓存与直接分解的差: " << (xc - xr).norm() << std::endl;
+        }
+        {
+            // 符号分解只做一次，对不同系数的 M + c * S 只进行数值分解
+            CSRMatrix K(mesh);
+            buildStiffnessMatrix(K, mesh);
+            CSRMatrix A(mesh);
+            Cholesky chol;
+            chol.setOrdering(Cholesky::RCM);
+            t.start();
+            chol.analyze(K);
+            t.stop("符号分解用时");
+            Vec xa(S.rows), Axa(S.rows);
+            for (double c : {0.1, 1.0})
+            {
+                blas_addMatrix(K, c, M, A);
+                t.start();
+                chol.factorize(A);
+                t.stop("数值分解用时");
+                chol.solve(b, xa);
+                A.MVP(xa, Axa);
+                std::cout << "c = " << c << " 残差: " << (Axa - b).norm() << std::endl;
+            }
+        }
+        {
+            // float存储L并进行迭代改进
+            Cholesky chol;
+            chol.setOrdering(Cholesky::RCM);
+            chol.setSinglePrecision(true);
+            chol.attach(S);
+            chol.compute();
+            Vec xf(S.rows);
+            t.start();
+            for (int k = 0; k < 10; ++k)
+            {
+                chol.solve(b, xf);
+            }
+            t.stop("混合精度求解10次用时");
+            S.MVP(xf, Ax);
+            std::cout << "混合精度 改进次数: " << chol.refineIter << " 残差: " << (Ax - b).norm() << " L大小: " << chol.Lf.size * sizeof(float) << " bytes" << std::endl;
+        }
+        S.MVP(xr, Ax);
+        std::cout << "RCM 残差: " << (Ax - b).norm() << " 与Natural的差: " << (xr - xn).norm() << std::endl;
+
+        Vec xs(S.rows);
+        SupernodalCholesky snchol;
+        t.start();
+        snchol.attach(S);
+        t.stop("超节点 符号分解用时");
+        t.start();
+        snchol.compute();
+        t.stop("超节点 数值分解用时");
+        snchol.solve(b, xs);
+        S.MVP(xs, Ax);
+        std::cout << "超节点 L大小: " << snchol.factorSize() << " 超节点数: " << snchol.nsuper << std::endl;
+        std::cout << "超节点 残差: " << (Ax - b).norm() << " 与Natural的差: " << (xs - xn).norm() << std::endl;
+
+        Eigen::SparseMatrix<double> eigen_matrix;
+        ConvertToEigenMatrix(S, eigen_matrix);
+        t.start();
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+        solver.compute(eigen_matrix);
+        t.stop("Eigen 分解用时");
+    }
+
     // int subdiv = 2;
     // double epsilon = 1e-6;
     // Mesh mesh(subdiv, SPHERE);
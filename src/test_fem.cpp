@@ -5,6 +5,11 @@
 #include <systemSolve.h>
 #include <timer.h>
 #include <string.h>
+#include <CSRMatrix.h>
+#include <omp.h>
+#include <random>
+#include <algorithm>
+#include <cmath>
 
 static double test_f(Vec3 pos)
 {
@@ -94,4 +99,84 @@ int main(int argc, char *argv[])
     std::cout << "用时: " << t.elapsedMilliseconds() << "ms" << std::endl;
 
     std::cout << "u[n - 1]: " << u[n - 1] << std::endl;
-}
\ No newline at end of file
+
+    // 无矩阵形式的 A = M + c * S 与CSR矩阵比较
+    {
+        double c = 0.01;
+        FEMatrix M1(mesh, FEMatrix::P1_Mass), S1(mesh, FEMatrix::P1_Stiffness), A1(mesh, FEMatrix::P1_Stiffness);
+        buildMassMatrix(M1);
+        buildStiffnessMatrix(S1);
+        blas_addMatrix(S1, c, M1, A1);
+
+        CSRMatrix Mc(mesh), Sc(mesh), Ac(mesh);
+        buildMassMatrix(Mc, mesh);
+        buildStiffnessMatrix(Sc, mesh);
+        blas_addMatrix(Sc, c, Mc, Ac);
+
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            A1.MVP(f, Ar);
+        t.stop("FEMatrix MVP x100");
+        t.start();
+        for (int k = 0; k < 100; ++k)
+            Ac.MVP(f, Ap);
+        t.stop("CSR MVP x100");
+        std::cout << "|y_fe - y_csr| / |y_csr|: " << (Ar - Ap).norm() / Ap.norm() << std::endl;
+
+        u.setAll(0.0);
+        conjugateGradientSolve(A1, B, u, r, p, Ap, &rel_error, &iter, 1e-10, 100000);
+        std::cout << "FEMatrix CG iter: " << iter << " rel_error: " << rel_error << std::endl;
+        u.setAll(0.0);
+        conjugateGradientSolve(Ac, B, u, r, p, Ap, &rel_error, &iter, 1e-10, 100000);
+        std::cout << "CSR CG iter: " << iter << " rel_error: " << rel_error << std::endl;
+    }
+
+    // 打乱三角形顺序后组装的CSR矩阵应与原顺序相同
+    // 至少用4个线程以走着色并行的路径，再禁止着色检查原子操作的路径
+    {
+        omp_set_num_threads(std::max(omp_get_max_threads(), 4));
+        Mesh shuffled;
+        shuffled.vertices = mesh.vertices;
+        shuffled.indices = mesh.indices;
+        size_t ntri = mesh.triangle_count();
+        std::mt19937 gen(1);
+        for (size_t t = ntri - 1; t > 0; --t)
+        {
+            size_t s = gen() % (t + 1);
+            for (int k = 0; k < 3; ++k)
+                std::swap(shuffled.indices[3 * t + k], shuffled.indices[3 * s + k]);
+        }
+
+        CSRMatrix A0(mesh), A1(shuffled), A2(shuffled);
+        buildWeightedMatrix(A0, mesh, 1.0, 0.01);
+        buildWeightedMatrix(A1, shuffled, 1.0, 0.01);
+        std::cout << "shuffled: " << shuffled.color_count() << " colors, block size " << shuffled.color_block_size << std::endl;
+
+        Mesh uncolored;
+        uncolored.vertices = shuffled.vertices;
+        uncolored.indices = shuffled.indices;
+        uncolored.coloring_failed = true;
+        buildWeightedMatrix(A2, uncolored, 1.0, 0.01);
+
+        double d1 = 0.0, d2 = 0.0;
+        for (size_t i = 0; i < A0.elements.size; ++i)
+        {
+            d1 = std::max(d1, std::abs(A0.elements[i] - A1.elements[i]));
+            d2 = std::max(d2, std::abs(A0.elements[i] - A2.elements[i]));
+        }
+        std::cout << "max |A - A_shuffled|: " << d1 << ", without coloring: " << d2 << std::endl;
+
+        // 无矩阵的MVP同样需要着色或原子操作
+        CSRMatrix Sc(mesh);
+        buildStiffnessMatrix(Sc, mesh);
+        Sc.MVP(f, Ap);
+        FEMatrix S1(shuffled, FEMatrix::P1_Stiffness), S2(uncolored, FEMatrix::P1_Stiffness);
+        buildStiffnessMatrix(S1);
+        buildStiffnessMatrix(S2);
+        S1.MVP(f, Ar);
+        double e1 = (Ar - Ap).norm() / Ap.norm();
+        S2.MVP(f, Ar);
+        double e2 = (Ar - Ap).norm() / Ap.norm();
+        std::cout << "|y_fe - y_csr| / |y_csr| shuffled: " << e1 << ", without coloring: " << e2 << std::endl;
+    }
+}
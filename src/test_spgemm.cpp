@@ -0,0 +1,161 @@
+#include <iostream>
+#include <CSRMatrix.h>
+#include <Mesh.h>
+#include <fem.h>
+#include <timer.h>
+#include <omp.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+
+#include <Eigen/Sparse>
+
+// 稀疏矩阵转置、乘法与Galerkin三重积的测试，并与Eigen比较
+
+static void toEigen(const CSRMatrix &A, Eigen::SparseMatrix<double, Eigen::RowMajor> &E)
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(A.elements.size);
+    for (int r = 0; r < A.rows; ++r)
+    {
+        for (uint32_t i = A.row_offset[r]; i < A.row_offset[r + 1]; ++i)
+        {
+            triplets.emplace_back(r, A.elm_idx[i], A.elements[i]);
+        }
+    }
+    E.resize(A.rows, A.cols);
+    E.setFromTriplets(triplets.begin(), triplets.end());
+}
+
+// 返回 |A - E|_F，同时检查每行列下标递增
+static double diffEigen(const CSRMatrix &A, const Eigen::SparseMatrix<double, Eigen::RowMajor> &E)
+{
+    Eigen::SparseMatrix<double, Eigen::RowMajor> B;
+    toEigen(A, B);
+    for (int r = 0; r < A.rows; ++r)
+    {
+        for (uint32_t i = A.row_offset[r] + 1; i < A.row_offset[r + 1]; ++i)
+        {
+            if (A.elm_idx[i - 1] >= A.elm_idx[i])
+            {
+                std::cout << "row " << r << " is not sorted" << std::endl;
+                return INFINITY;
+            }
+        }
+    }
+    return (B - E).norm();
+}
+
+// 贪心聚合: 未聚合的点与其未聚合的邻点组成一个聚合，P(v, agg(v)) = 1
+static CSRMatrix aggregate(const CSRMatrix &A)
+{
+    std::vector<int> agg(A.rows, -1);
+    int nagg = 0;
+    for (int r = 0; r < A.rows; ++r)
+    {
+        if (agg[r] >= 0)
+            continue;
+        for (uint32_t i = A.row_offset[r]; i < A.row_offset[r + 1]; ++i)
+        {
+            if (agg[A.elm_idx[i]] < 0)
+                agg[A.elm_idx[i]] = nagg;
+        }
+        ++nagg;
+    }
+
+    auto pat = std::make_shared<CSRPattern>(A.rows);
+    pat->elm_idx.resize(A.rows);
+    for (int r = 0; r < A.rows; ++r)
+    {
+        pat->row_offset[r + 1] = r + 1;
+        pat->elm_idx[r] = agg[r];
+    }
+    CSRMatrix P(A.rows, nagg, pat);
+    for (int r = 0; r < A.rows; ++r)
+        P.elements[r] = 1.0;
+    return P;
+}
+
+int main(int argc, char *argv[])
+{
+    int subdiv = (argc > 1) ? atoi(argv[1]) : 100;
+    int threads = (argc > 2) ? atoi(argv[2]) : 1;
+    omp_set_num_threads(threads);
+
+    Mesh mesh(subdiv, SPHERE);
+    CSRMatrix A(mesh);
+    buildWeightedMatrix(A, mesh, 1.0, 0.01);
+    std::cout << "A.rows: " << A.rows << " nnz: " << A.elements.size << std::endl;
+
+    Eigen::SparseMatrix<double, Eigen::RowMajor> eA, eB, eC;
+    toEigen(A, eA);
+    Timer t;
+
+    // 转置
+    CSRMatrix P0 = aggregate(A);
+    t.start();
+    CSRMatrix P0t = transpose(P0);
+    t.stop("transpose");
+    toEigen(P0, eB);
+    t.start();
+    eC = eB.transpose();
+    t.stop("Eigen transpose");
+    std::cout << "|P^T - P^T_eigen|: " << diffEigen(P0t, eC) << std::endl;
+
+    // 光滑聚合的插值 P = (I - 2/3 D^{-1} A) P0，先用 A * P0 计算
+    t.start();
+    CSRMatrix AP = multiply(A, P0);
+    t.stop("A * P0");
+    t.start();
+    eC = eA * eB;
+    t.stop("Eigen A * P0");
+    std::cout << "|AP - AP_eigen|: " << diffEigen(AP, eC) << std::endl;
+
+    CSRMatrix P = AP;
+    for (int r = 0; r < A.rows; ++r)
+    {
+        double d = A(r, r);
+        for (uint32_t i = P.row_offset[r]; i < P.row_offset[r + 1]; ++i)
+        {
+            P.elements[i] = (P.elm_idx[i] == P0.elm_idx[r] ? 1.0 : 0.0) - 2.0 / 3.0 / d * AP.elements[i];
+        }
+    }
+    std::cout << "P: " << P.rows << " x " << P.cols << " nnz: " << P.elements.size << std::endl;
+
+    // A * A
+    t.start();
+    CSRMatrix A2 = multiply(A, A);
+    t.stop("A * A");
+    t.start();
+    eC = eA * eA;
+    t.stop("Eigen A * A");
+    std::cout << "|A^2 - A^2_eigen|: " << diffEigen(A2, eC) << " nnz: " << A2.elements.size << std::endl;
+    t.start();
+    multiplyNumeric(A, A, A2);
+    t.stop("A * A (numeric only)");
+
+    // P^T A P
+    toEigen(P, eB);
+    t.start();
+    CSRMatrix Ac = galerkinProduct(A, P);
+    t.stop("P^T A P (fused)");
+    CSRMatrix Pt = transpose(P);
+    t.start();
+    tripleProductNumeric(Pt, A, P, Ac);
+    t.stop("P^T A P (numeric only)");
+    t.start();
+    CSRMatrix Ac2 = multiply(Pt, multiply(A, P));
+    t.stop("P^T A P (two products)");
+    t.start();
+    eC = Eigen::SparseMatrix<double, Eigen::RowMajor>(eB.transpose()) * (eA * eB);
+    t.stop("Eigen P^T A P");
+    std::cout << "Ac: " << Ac.rows << " x " << Ac.cols << " nnz: " << Ac.elements.size << std::endl;
+    std::cout << "|Ac - Ac_eigen|: " << diffEigen(Ac, eC) << " |Ac - Ac2|: " << diffEigen(Ac2, eC) << std::endl;
+
+    // 粗网格算子应保持对称
+    CSRMatrix Act = transpose(Ac);
+    double asym = 0.0;
+    for (size_t i = 0; i < Ac.elements.size; ++i)
+        asym = std::max(asym, std::abs(Ac.elements[i] - Act.elements[i]));
+    std::cout << "max |Ac - Ac^T|: " << asym << std::endl;
+}